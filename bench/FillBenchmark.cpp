@@ -0,0 +1,149 @@
+// Measures what the fill plan saves, in cells per second : the batch noise
+// fill recomputing the octave frequencies, amplitudes and closed edges
+// weight for every cell against CellGrid::fillGrid with a plan, both on the
+// calling thread. The plan fill on the thread pool is listed apart.
+//
+// usage : FillBenchmark [size...]   (default sizes : 50 128 256)
+
+#include <FastNoise.h>
+#include <CellGrid.h>
+#include <FillPlan.h>
+#include <ThreadPool.h>
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+#define OCTAVES         3
+#define LACUNARITY      2.f
+#define PERSISTANCE     0.5f
+#define NOISE_SCALE     3.f
+
+using namespace std;
+
+
+// fillGrid with the batch noise functions but without the fill plan : the
+// frequency and amplitude of each octave and the closed edges weight are
+// recomputed for every cell, as before the plan
+static void unplannedFillGrid(CellGrid& grid, FastNoise& noise, int octaves, float lacunarity, float persistance, float scale)
+{
+    int depth = grid.depth;
+    vector<float> rowX(depth), rowY(depth), rowZ(depth);
+    vector<float> rowNoise(depth);
+    vector<double> rowValue(depth);
+
+    float posX, posY, posZ;
+    float weight;
+
+    for(int i = 0; i < grid.width; i++){
+        for(int j = 0; j < grid.height; j++){
+
+            fill(rowValue.begin(), rowValue.end(), 0.);
+
+            for(int u = 0; u < octaves; u++){
+                for(int k = 0; k < depth; k++){
+                    float frequency = pow(lacunarity, u) * scale;
+                    rowX[k] = (float)i * frequency;
+                    rowY[k] = (float)j * frequency;
+                    rowZ[k] = (float)k * frequency;
+                }
+
+                noise.GetNoiseSet(rowX.data(), rowY.data(), rowZ.data(), rowNoise.data(), depth);
+
+                for(int k = 0; k < depth; k++){
+                    rowValue[k] += rowNoise[k] * pow(persistance, u);
+                }
+            }
+
+            for(int k = 0; k < depth; k++){
+                posX = fabs((float)i - (float)grid.width / 2.f + 0.5f) * 2.f;
+                posY = fabs((float)j - (float)grid.height / 2.f + 0.5f) * 2.f;
+                posZ = fabs((float)k - (float)grid.depth / 2.f + 0.5f) * 2.f;
+
+                posX += -grid.width + 2.f;
+                posY += -grid.height + 2.f;
+                posZ += -grid.depth + 2.f;
+
+                weight = max(posX, max(posY, posZ));
+
+                weight = weight < 0.f ? 0.f : weight > 1.f ? 1.f : weight;
+
+                grid.at(i, j, k) = (float)rowValue[k] * (1 - weight) - 100.f * weight;
+            }
+        }
+    }
+}
+
+// best time of a few runs, in seconds
+static double measure(int runs, const function<void()>& run)
+{
+    double best = 0.;
+
+    for(int r = 0; r < runs; r++){
+        auto startTime = chrono::high_resolution_clock::now();
+        run();
+        auto finishTime = chrono::high_resolution_clock::now();
+
+        double seconds = chrono::duration<double>(finishTime - startTime).count();
+        if(r == 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<int> sizes;
+    for(int a = 1; a < argc; a++){
+        sizes.push_back(atoi(argv[a]));
+    }
+    if(sizes.empty())
+        sizes = { 50, 128, 256 };
+
+    FastNoise noise;
+    noise.SetNoiseType(FastNoise::Simplex);
+    noise.SetSeed(1337);
+
+    ThreadPool pool;
+
+    // batch : no plan, 1 thread - plan : with a plan, 1 thread - gain : plan over batch
+    // plan+pool : with a plan, on all the pool threads
+    cout << "fill throughput in Mcells/s" << endl;
+    cout << setw(6) << "size" << setw(12) << "batch" << setw(12) << "plan" << setw(10) << "gain"
+         << setw(12) << "plan+pool" << " (" << pool.getThreadCount() << " threads)" << endl;
+
+    for(int size : sizes){
+        CellGrid grid(size, size, size);
+        double cells = (double)size * size * size;
+        int runs = size <= 64 ? 5 : size <= 128 ? 3 : 1;
+
+        double unplanned = measure(runs, [&](){
+            unplannedFillGrid(grid, noise, OCTAVES, LACUNARITY, PERSISTANCE, NOISE_SCALE);
+        });
+
+        FillPlan plan(size, size, size, OCTAVES, LACUNARITY, PERSISTANCE, NOISE_SCALE);
+
+        double planned = measure(runs, [&](){
+            grid.fillGrid(noise, plan);
+        });
+
+        double parallel = measure(runs, [&](){
+            grid.fillGrid(noise, plan, pool);
+        });
+
+        cout << fixed << setprecision(2);
+        cout << setw(6) << size;
+        cout << setw(12) << cells / unplanned / 1e6;
+        cout << setw(12) << cells / planned / 1e6;
+        cout << setw(9) << unplanned / planned << "x";
+        cout << setw(12) << cells / parallel / 1e6 << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+// Times each stage of the generation pipeline independently, over several
+// grid sizes and seeds, and writes the median and 95th percentile duration
+// and the throughput of each stage as JSON.
+//
+// usage : PipelineBenchmark [--sizes 32,64,128] [--seeds 1,2,3] [--runs 3]
+//                           [--threads 0] [--output results.json]
+//
+// Every (seed, run) pair gives one sample per stage. The throughput is
+// computed from the median : cells of the grid per second and triangles
+// of the final mesh per second.
+
+#include <FastNoise.h>
+#include <CellGrid.h>
+#include <CubeGrid.h>
+#include <Mesh.h>
+#include <ThreadPool.h>
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+#define OCTAVES         3
+#define LACUNARITY      2.f
+#define PERSISTANCE     0.5f
+#define NOISE_SCALE     3.f
+#define SURFACE_LEVEL   0.5f
+#define CUBE_SIZE       0.1f
+#define MIN_REGION_SIZE 1000
+
+using namespace std;
+
+
+// durations of one stage, in milliseconds
+struct Stage
+{
+    string name;
+    vector<double> samples;
+};
+
+// milliseconds taken by run
+static double measure(const function<void()>& run)
+{
+    auto startTime = chrono::high_resolution_clock::now();
+    run();
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+}
+
+// nearest rank percentile of the samples, in [0, 100]
+static double percentile(vector<double> samples, double rank)
+{
+    if(samples.empty())
+        return 0.;
+
+    sort(samples.begin(), samples.end());
+    size_t index = (size_t)ceil(rank / 100. * samples.size());
+    return samples[index > 0 ? index - 1 : 0];
+}
+
+// comma separated list of integers
+static vector<int> parseList(const string& text)
+{
+    vector<int> values;
+    stringstream stream(text);
+    string item;
+
+    while(getline(stream, item, ',')){
+        if(!item.empty())
+            values.push_back(atoi(item.c_str()));
+    }
+
+    return values;
+}
+
+static void writeList(ostream& out, const vector<int>& values)
+{
+    out << "[";
+    for(size_t v = 0; v < values.size(); v++){
+        out << (v > 0 ? ", " : "") << values[v];
+    }
+    out << "]";
+}
+
+int main(int argc, char *argv[])
+{
+    vector<int> sizes = { 32, 64, 128 };
+    vector<int> seeds = { 1, 2, 3 };
+    int runs = 3;
+    int threadCount = 0;
+    string output;
+
+    for(int a = 1; a < argc; a += 2){
+        string option = argv[a];
+        if(a + 1 == argc){
+            cerr << "missing value for option " << option << endl;
+            return EXIT_FAILURE;
+        }
+        string value = argv[a + 1];
+
+        if(option == "--sizes")
+            sizes = parseList(value);
+        else if(option == "--seeds")
+            seeds = parseList(value);
+        else if(option == "--runs")
+            runs = max(1, atoi(value.c_str()));
+        else if(option == "--threads")
+            threadCount = atoi(value.c_str());
+        else if(option == "--output")
+            output = value;
+        else {
+            cerr << "unknown option " << option << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // a grid needs 2 nodes along each side to have a cube
+    for(int size : sizes){
+        if(size < 2){
+            cerr << "invalid size " << size << ", sizes must be at least 2" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    ThreadPool pool(threadCount);
+    FastNoise noise;
+    noise.SetNoiseType(FastNoise::Simplex);
+
+    stringstream json;
+    json << fixed << setprecision(4);
+    json << "{\n";
+    json << "  \"threads\": " << pool.getThreadCount() << ",\n";
+    json << "  \"runs\": " << runs << ",\n";
+    json << "  \"seeds\": ";
+    writeList(json, seeds);
+    json << ",\n";
+    json << "  \"results\": [";
+
+    for(size_t s = 0; s < sizes.size(); s++){
+        int size = sizes[s];
+
+        vector<Stage> stages = {
+            { "fillGrid", {} },
+            { "generateGrid", {} },
+            { "generateGrid.createNodes", {} },
+            { "generateGrid.ignoreSmallRegions", {} },
+            { "marchCubes", {} },
+            { "generateMesh", {} },
+            { "generateMesh.marchCubes", {} },
+            { "generateMesh.ignoreSmallRegions", {} },
+            { "generateMesh.adjacency", {} },
+            { "generateMesh.normals", {} },
+            { "getVertexArray", {} },
+            { "getTriangleArray", {} },
+        };
+        vector<double> triangleCounts;
+
+        CellGrid cellGrid(size, size, size);
+
+        for(int seed : seeds){
+            noise.SetSeed(seed);
+
+            for(int r = 0; r < runs; r++){
+                CubeGrid cubeGrid;
+                Mesh mesh;
+                int stage = 0;
+
+                stages[stage++].samples.push_back(measure([&](){
+                    cellGrid.fillGrid(noise, OCTAVES, LACUNARITY, PERSISTANCE, NOISE_SCALE, pool);
+                }));
+
+                stages[stage++].samples.push_back(measure([&](){
+                    cubeGrid.generateGrid(cellGrid, CUBE_SIZE, SURFACE_LEVEL, MIN_REGION_SIZE, pool);
+                }));
+                stages[stage++].samples.push_back(cubeGrid.timings.createNodes);
+                stages[stage++].samples.push_back(cubeGrid.timings.ignoreSmallRegions);
+
+                // single threaded streaming march, on its own
+                vector<Vertex> vertices;
+                vector<Triangle> triangles;
+                stages[stage++].samples.push_back(measure([&](){
+                    cubeGrid.marchCubes(vertices, triangles);
+                }));
+
+                stages[stage++].samples.push_back(measure([&](){
+                    mesh.generateMesh(cubeGrid, MIN_REGION_SIZE, pool);
+                }));
+                stages[stage++].samples.push_back(mesh.timings.marchCubes);
+                stages[stage++].samples.push_back(mesh.timings.ignoreSmallRegions);
+                stages[stage++].samples.push_back(mesh.timings.adjacency);
+                stages[stage++].samples.push_back(mesh.timings.normals);
+
+                stages[stage++].samples.push_back(measure([&](){
+                    delete[] mesh.getVertexArray();
+                }));
+                stages[stage++].samples.push_back(measure([&](){
+                    delete[] mesh.getTriangleArray();
+                }));
+
+                triangleCounts.push_back((double)mesh.triangles.size());
+            }
+        }
+
+        double cells = (double)size * size * size;
+        double triangles = percentile(triangleCounts, 50.);
+
+        json << (s > 0 ? "," : "") << "\n    {\n";
+        json << "      \"size\": " << size << ",\n";
+        json << "      \"cells\": " << (long long)cells << ",\n";
+        json << "      \"triangles\": " << (long long)triangles << ",\n";
+        json << "      \"stages\": {";
+
+        for(size_t n = 0; n < stages.size(); n++){
+            double median = percentile(stages[n].samples, 50.);
+            double p95 = percentile(stages[n].samples, 95.);
+            double seconds = max(median, 1e-6) / 1000.;
+
+            json << (n > 0 ? "," : "") << "\n        \"" << stages[n].name << "\": { ";
+            json << "\"median_ms\": " << median << ", ";
+            json << "\"p95_ms\": " << p95 << ", ";
+            json << "\"cells_per_second\": " << setprecision(0) << cells / seconds << ", ";
+            json << "\"triangles_per_second\": " << triangles / seconds << setprecision(4) << " }";
+        }
+
+        json << "\n      }\n    }";
+
+        cerr << "size " << size << " done" << endl;
+    }
+
+    json << "\n  ]\n}\n";
+
+    if(output.empty()){
+        cout << json.str();
+    } else {
+        ofstream file(output);
+        file << json.str();
+        if(!file){
+            cerr << "could not write " << output << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
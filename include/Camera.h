@@ -16,8 +16,11 @@ class Camera
         Camera(vec3d _pos, float _rotSpeed, float _zoomSpeed);
         void enableMovement();
         void disableMovement();
-        // Calculate camera eye coordinates
+        // Calculate camera eye coordinates, around the center
         void update();
+        // Move the center along the ground : forward goes where the camera
+        // looks, right to its right, up along y
+        void moveCenter(float forward, float right, float up);
         // Update spherical angles according to mouse movements
         void updatePos(float mouseX, float mouseY, float deltaTime);
         // Update the distance to the center of the scene
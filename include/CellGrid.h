@@ -2,28 +2,86 @@
 #define CELLGRID_H
 
 #include <FastNoise.h>
+#include <ThreadPool.h>
+#include <FillPlan.h>
+#include <cstddef>
 
 using namespace std;
 
+// 3D scalar field stored in a single aligned contiguous buffer
 
 class CellGrid
 {
     public:
-        float ***cells;
+        // memory layout of the cells inside the buffer :
+        // - XMajor : cells[(i*height + j)*depth + k], k is contiguous
+        // - ZMajor : cells[(k*height + j)*width + i], i is contiguous
+        // - MortonBricks : 8x8x8 bricks stored one after the other (x-major),
+        //   cells inside a brick in Morton (Z-order) order
+        enum MemoryOrder { XMajor, ZMajor, MortonBricks };
+
+        static const int BRICK_SIZE = 8;
+        static const size_t ALIGNMENT = 64;
+
+        float *cells = nullptr;
         int width = 0;
         int height = 0;
         int depth = 0;
+        MemoryOrder order = XMajor;
 
         CellGrid();
-        CellGrid(int _width, int _height, int _depth);
+        CellGrid(int _width, int _height, int _depth, MemoryOrder _order = XMajor);
+        CellGrid(const CellGrid& other);
+        CellGrid(CellGrid&& other);
+        CellGrid& operator = (CellGrid other);
+
+        // position of the cell (i, j, k) in the cells buffer
+        size_t index(int i, int j, int k) const;
+        float& at(int i, int j, int k) { return cells[index(i, j, k)]; }
+        float at(int i, int j, int k) const { return cells[index(i, j, k)]; }
+        // number of floats allocated, including the padding of partial bricks
+        size_t size() const { return cellCount; }
+        // bytes of the cells buffer
+        size_t memorySize() const { return cellCount * sizeof(float); }
 
         // fill the grid with 3D noise values
         void fillGrid(FastNoise& noise, int octaves, float lacunarity, float persistance, float scale);
+        // same as above, the grid is split in slabs filled concurrently by the pool
+        void fillGrid(FastNoise& noise, int octaves, float lacunarity, float persistance, float scale, ThreadPool& pool);
+        // fill the grid from a precomputed plan, built for the grid dimensions
+        void fillGrid(FastNoise& noise, const FillPlan& plan);
+        void fillGrid(FastNoise& noise, const FillPlan& plan, ThreadPool& pool);
         virtual ~CellGrid();
 
     protected:
 
     private:
+        size_t cellCount = 0;
+        // number of bricks along y and z, only used by the MortonBricks order
+        int bricksY = 0;
+        int bricksZ = 0;
+
+        void allocate();
+        void release();
+        // fill the cells in [iStart, iEnd) x [jStart, jEnd) x [kStart, kEnd)
+        void fillRegion(const FastNoise& noise, const FillPlan& plan, int iStart, int iEnd, int jStart, int jEnd, int kStart, int kEnd);
 };
 
+inline size_t CellGrid::index(int i, int j, int k) const
+{
+    if(order == XMajor)
+        return ((size_t)i * height + j) * depth + k;
+    if(order == ZMajor)
+        return ((size_t)k * height + j) * width + i;
+
+    // spreads the 3 bits of a coordinate inside a brick so they can be
+    // interleaved into a 9 bits Morton code
+    static const int spread[BRICK_SIZE] = { 0, 1, 8, 9, 64, 65, 72, 73 };
+
+    size_t brick = ((size_t)(i >> 3) * bricksY + (j >> 3)) * bricksZ + (k >> 3);
+    int morton = spread[i & 7] | (spread[j & 7] << 1) | (spread[k & 7] << 2);
+
+    return brick * (BRICK_SIZE*BRICK_SIZE*BRICK_SIZE) + morton;
+}
+
 #endif // CELLGRID_H
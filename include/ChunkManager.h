@@ -0,0 +1,146 @@
+#ifndef CHUNKMANAGER_H
+#define CHUNKMANAGER_H
+
+#include <FastNoise.h>
+#include <Mesh.h>
+#include <Coord.h>
+#include <vec3d.h>
+#include <ThreadPool.h>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+// Streams an unbounded terrain as cubic chunks of chunkSize cubes keyed by
+// their integer chunk coordinates. Each update keeps the chunks around a
+// position : the missing ones nearest to it are meshed in the background
+// by the thread pool, the far ones are evicted so the number of resident
+// chunks stays bounded.
+// The noise is sampled at global cell coordinates without closed edges, so
+// two neighbour chunks compute the same values on the face they share and
+// their meshes meet without any seam. The gradient normals are taken from
+// one more node around each chunk, they match across the faces too.
+
+class ChunkManager
+{
+    public:
+        // everything needed to generate a chunk, copied by each job so the
+        // settings can change while chunks are being meshed
+        struct Settings
+        {
+            // number of cubes along each side of a chunk
+            int chunkSize = 32;
+
+            // noise function parameters
+            int octaves = 3;
+            float lacunarity = 2.f;
+            float persistance = 0.5f;
+            float noiseScale = 3.f;
+
+            // cube grid parameters
+            float surfaceLevel = 0.5f;
+            float cubeSize = 0.1f;
+
+            // the gradient of the field is the only mode not needing the
+            // triangles of the neighbour chunks
+            Mesh::NormalMode normalMode = Mesh::FieldGradient;
+            bool optimizeMesh = true;
+        };
+
+        struct Chunk
+        {
+            Coord coord;
+            // world position of the chunk center, the mesh is centered on it
+            vec3d center;
+            Mesh mesh;
+        };
+
+        Settings settings;
+        FastNoise noise;
+
+        // chunks kept around the position, in chunks
+        int viewDistance = 4;
+        // bound of the resident chunks, the farthest ones are evicted first
+        size_t maxResidentChunks = 512;
+        // chunks meshed at the same time, 0 uses twice the number of threads
+        size_t maxPendingChunks = 0;
+
+        // threadCount <= 0 uses the number of hardware threads
+        ChunkManager(int threadCount = 0);
+        ChunkManager(const ChunkManager&) = delete;
+        ChunkManager& operator = (const ChunkManager&) = delete;
+
+        int getThreadCount() const { return pool.getThreadCount(); }
+
+        // coordinates of the chunk containing a world position
+        Coord chunkAt(const vec3d& position) const;
+        vec3d chunkCenter(const Coord& coord) const;
+
+        // Collects the chunks meshed since the last call, evicts the ones out
+        // of reach and schedules the nearest missing ones around position.
+        // Never waits for the background jobs.
+        void update(const vec3d& position);
+        // Evicts every chunk and drops the jobs in flight, to be called after
+        // changing the noise or the settings
+        void reset();
+
+        // resident chunk at coord, nullptr if it isn't loaded
+        const Chunk* getChunk(const Coord& coord) const;
+        size_t getResidentCount() const { return resident.size(); }
+        size_t getPendingCount() const { return pending.size(); }
+
+        // Coordinates of the chunks loaded (or evicted) by the updates since
+        // the last call, in order. A coordinate may appear in both lists if the
+        // chunk was evicted and loaded again in between, only the chunks still
+        // resident can be read with getChunk.
+        vector<Coord> takeLoadedChunks();
+        vector<Coord> takeEvictedChunks();
+
+        // generates the mesh of the chunk at chunk.coord on the calling thread
+        static void generateChunk(Chunk& chunk, const Settings& settings, FastNoise& noise);
+
+        virtual ~ChunkManager();
+
+    protected:
+
+    private:
+        // chunk meshed by a job, ignored if the manager was reset since
+        struct Result
+        {
+            unsigned int generation;
+            unique_ptr<Chunk> chunk;
+        };
+
+        map<Coord, unique_ptr<Chunk>> resident;
+        set<Coord> pending;
+        vector<Coord> loaded;
+        vector<Coord> evicted;
+
+        // chunk offsets within viewDistance, nearest first
+        vector<Coord> offsets;
+        int offsetsDistance = -1;
+
+        // the jobs hand their chunks over through finished
+        mutex finishedLock;
+        vector<Result> finished;
+        // incremented by each reset, the jobs of previous generations are dropped
+        atomic<unsigned int> generation;
+
+        // declared last so it is destroyed first, while the jobs can still
+        // push their results
+        ThreadPool pool;
+
+        // squared distance in chunks between two chunk coordinates
+        static long long distance2(const Coord& c1, const Coord& c2);
+        void collectFinished(const Coord& center);
+        void evictChunks(const Coord& center);
+        void scheduleChunks(const Coord& center);
+        void evict(map<Coord, unique_ptr<Chunk>>::iterator it);
+};
+
+#endif // CHUNKMANAGER_H
@@ -8,4 +8,8 @@ struct Coord
     Coord(int _i, int _j, int _k);
 };
 
+bool operator == (const Coord& c1, const Coord& c2);
+bool operator != (const Coord& c1, const Coord& c2);
+bool operator < (const Coord& c1, const Coord& c2); // for use as map key
+
 #endif // COORD_H
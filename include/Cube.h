@@ -2,10 +2,12 @@
 #define CUBE_H
 
 #include <vec3d.h>
-#include <ControlNode.h>
+#include <NodeField.h>
+#include <EdgeCache.h>
 #include <vector>
 #include <utility>
 #include <Vertex.h>
+#include <Triangle.h>
 
 using namespace std;
 
@@ -16,23 +18,34 @@ using namespace std;
 class Cube
 {
     public:
-        ControlNode **controlNodes;
-        int *edgeNodes;
+        const NodeField *nodes;
+        int i, j, k; // coordinates of the first node of the cube
+        int edgeNodes[12];
         int configuration;
-        int bordering;
 
         Cube();
-        Cube(ControlNode **_controlNodes, int _bordering);
-
-        // create the necessary edge vertices of the cube
-        void createVertices(vector<Vertex>& vertices, float surfaceLevel);
+        Cube(const NodeField& _nodes, int _i, int _j, int _k);
+
+        // get the edge vertices of the cube from the cache, creating the
+        // ones not already created by a neighbouring cube
+        void createVertices(vector<Vertex>& vertices, EdgeCache& edgeCache, float surfaceLevel);
+        // get the edge vertices of the cube from the cache, where all of them
+        // have already been created
+        void readVertices(EdgeCache& edgeCache);
+        // create the triangles of the cube according to its configuration
+        void createTriangles(vector<Triangle>& triangles) const;
+        // same as above, the triangles are written from the given position,
+        // returns the position after the last one
+        Triangle* createTriangles(Triangle *triangles) const;
+        // add the area weighted normal of each triangle of the cube
+        // to the normals of its vertices
+        void accumulateNormals(vector<Vertex>& vertices) const;
 
         virtual ~Cube();
 
     protected:
 
     private:
-        vec3d interpolate(int a, int b, float t);
 };
 
 #endif // CUBE_H
@@ -2,42 +2,95 @@
 #define CUBEGRID_H
 
 #include <Cube.h>
-#include <ControlNode.h>
+#include <NodeField.h>
 #include <CellGrid.h>
 #include <vector>
 #include <vec3d.h>
-#include <Coord.h>
 #include <Vertex.h>
+#include <Triangle.h>
+#include <EdgeCache.h>
+#include <ThreadPool.h>
+#include <UnionFind.h>
+#include <cstddef>
 
 // class generating and storing the 3D grid of cubes
 
 class CubeGrid
 {
     public:
+        // durations of the steps of the last generateGrid call, in milliseconds
+        struct Timings
+        {
+            double createNodes, ignoreSmallRegions;
+        };
+
         int width = 0;
         int height = 0;
         int depth = 0;
         float cubeSize;
         float surfaceLevel;
-        ControlNode ***controlNodes;
-        Cube ***cubes;
+        NodeField nodes;
+        Timings timings = {};
 
         CubeGrid();
         // Generates the controls nodes from the cell grid and filters small regions
         void generateGrid(CellGrid& cellGrid, float _cubeSize, float _surfaceLevel, unsigned int minRegionSize);
-        // Generates each cubes and their edge vertices
-        void marchCubes(vector<Vertex>& vertices);
+        // same as above, the small regions are labeled in parallel on the pool
+        void generateGrid(CellGrid& cellGrid, float _cubeSize, float _surfaceLevel, unsigned int minRegionSize, ThreadPool& pool);
+        // Generates the edge vertices and the triangles of each cube, adding the area
+        // weighted normal of each triangle to its vertices if accumulateNormals is set
+        void marchCubes(vector<Vertex>& vertices, vector<Triangle>& triangles, bool accumulateNormals = false);
+        // Same as above, but first counts the vertices created by each node slice
+        // and the triangles created by each cube slice, so the output vectors are
+        // sized once to their exact size and filled in place.
+        // Vertices are numbered node slice by node slice.
+        void marchCubesInPlace(vector<Vertex>& vertices, vector<Triangle>& triangles);
+        // same as above, the slices are counted and then marched by slabs on the pool.
+        // The output is identical whatever the number of threads.
+        void marchCubesInPlace(vector<Vertex>& vertices, vector<Triangle>& triangles, ThreadPool& pool);
         void clear();
         virtual ~CubeGrid();
 
     protected:
 
     private:
+        // run of consecutive active nodes [start, end) along x in a row of nodes
+        struct NodeRun
+        {
+            int start;
+            int end;
+        };
+
+        // Stores the value and state of each node from the cell grid
+        void createNodes(CellGrid& cellGrid, float _cubeSize, float _surfaceLevel);
         // Set as not active all nodes belonging to small regions we don't want to see.
-        void ignoreSmallRegions(CellGrid& cellGrid, unsigned int minNodeCount);
-        // Utility method used by the ignoreSmallRegions methode : apply floodfill to get
-        // nodes per regions from a starting node
-        void detectRegionNodes(CellGrid& cellGrid, Coord startCoord, bool ***visited, vector<Coord>& regionNodes);
+        // The labeling is done in parallel if pool isn't null.
+        void ignoreSmallRegions(unsigned int minNodeCount, ThreadPool *pool);
+        // Utility method used by the ignoreSmallRegions method : appends the runs
+        // of active nodes of the row (j, k)
+        void findRowRuns(int j, int k, vector<NodeRun>& runs) const;
+        // Utility method used by the ignoreSmallRegions method : merges the regions
+        // of the runs of row with the ones of other they touch, runs being
+        // extended by reach nodes along x (1 for rows sharing a face, 0 for rows
+        // only sharing an edge)
+        static void connectRows(UnionFind& regions, const vector<NodeRun>& runs, const vector<unsigned int>& rowFirstRun,
+                                int row, int other, int reach);
+        // Implements marchCubesInPlace, serially if pool is null
+        void marchInPlace(vector<Vertex>& vertices, vector<Triangle>& triangles, ThreadPool *pool);
+        // Number of edges starting from the node slice k that cross the surface
+        size_t countSliceVertices(int k) const;
+        // Number of triangles created by the cubes of the slice k
+        size_t countSliceTriangles(int k) const;
+        // Stores in the cache the vertex indices of the crossing edges of the node
+        // slice k, numbered from firstVertex, and creates their vertices if
+        // vertices isn't null
+        void indexSliceVertices(int k, size_t firstVertex, EdgeCache& edgeCache, Vertex *vertices) const;
+        // Marches the cube slices [kStart, kEnd) writing the vertices and triangles
+        // at the offsets computed from the slice counts. The slab creates the
+        // vertices of the node slices [kStart, kEnd), plus the last one for the
+        // last slab, and only reads the indices of the node slice kEnd.
+        void marchSlab(int kStart, int kEnd, const vector<size_t>& vertexOffsets, const vector<size_t>& triangleOffsets,
+                       Vertex *vertices, Triangle *triangles) const;
 };
 
 #endif // CUBEGRID_H
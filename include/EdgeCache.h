@@ -0,0 +1,48 @@
+#ifndef EDGECACHE_H
+#define EDGECACHE_H
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// Vertex index of each edge crossing the surface, so that a vertex shared
+// by several cubes is interpolated once. An edge is identified by the node
+// it starts from and its axis (0 : x, 1 : y, 2 : z), i.e. the global edge id
+// node index * 3 + axis.
+// Cubes are marched one z slice at a time and only reach the edges of two
+// node slices, so the cache only keeps two slices of edges : the slots of
+// the slice k are reused for the slice k + 2.
+
+class EdgeCache
+{
+    public:
+        // value of an edge whose vertex hasn't been created
+        static constexpr int NO_VERTEX = -1;
+
+        EdgeCache();
+        // the node slices are width x height nodes
+        EdgeCache(int _width, int _height);
+
+        // vertex index of the edge starting at the node (i, j, k) along axis
+        int& vertex(int i, int j, int k, int axis);
+        // forget the edges starting from the node slice k, before reusing them
+        void clearSlice(int k);
+
+        virtual ~EdgeCache();
+
+    protected:
+
+    private:
+        int width = 0;
+        int height = 0;
+        vector<int> slots;
+};
+
+inline int& EdgeCache::vertex(int i, int j, int k, int axis)
+{
+    size_t slice = (size_t)(k & 1) * width * height;
+    return slots[(slice + (size_t)j * width + i) * 3 + axis];
+}
+
+#endif // EDGECACHE_H
@@ -213,6 +213,29 @@ public:
 	FN_DECIMAL GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const;
 	FN_DECIMAL GetWhiteNoiseInt(int x, int y, int z, int w) const;
 
+	//Batch
+	// Instruction sets the batch functions can use
+	enum SIMDLevel { SIMD_None, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+
+	// Returns the best instruction set supported by the CPU, detected at runtime
+	static SIMDLevel GetSupportedSIMDLevel();
+
+	// Sets the instruction set used by the batch functions, clamped to the supported one
+	// Default: GetSupportedSIMDLevel()
+	void SetSIMDLevel(SIMDLevel simdLevel);
+	// Returns the instruction set used by the batch functions
+	SIMDLevel GetSIMDLevel() const { return m_simdLevel; }
+
+	// Sets noiseSet[i] to GetNoise(x[i], y[i], z[i]) for i in [0, count)
+	// Simplex, Perlin and Value noise are evaluated by SIMD kernels giving the same values,
+	// the other noise types fall back to GetNoise
+	void GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* noiseSet, int count) const;
+
+	// Fills noiseSet with the noise of an axis aligned grid region, the sample (ix, iy, iz)
+	// is GetNoise((xStart + ix) * scaleModifier, (yStart + iy) * scaleModifier, (zStart + iz) * scaleModifier)
+	// and is stored at noiseSet[(ix * ySize + iy) * zSize + iz]
+	void FillNoiseSet(FN_DECIMAL* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, FN_DECIMAL scaleModifier = 1) const;
+
 private:
 	unsigned char m_perm[512];
 	unsigned char m_perm12[512];
@@ -237,6 +260,11 @@ private:
 
 	FN_DECIMAL m_gradientPerturbAmp = FN_DECIMAL(1);
 
+	// permutation tables widened for the SIMD gathers
+	int m_permInt[512];
+	int m_perm12Int[512];
+	SIMDLevel m_simdLevel = GetSupportedSIMDLevel();
+
 	void CalculateFractalBounding();
 
 	//2D
@@ -0,0 +1,53 @@
+// FastNoiseBatch.h
+//
+// SIMD kernels used by FastNoise::GetNoiseSet and FastNoise::FillNoiseSet.
+// Each instruction set has its own translation unit so the kernels can be
+// compiled for it while the rest of the program keeps the default target,
+// the kernel set to use is selected at runtime from the CPU features.
+//
+// The kernels reproduce the floating point operations of the scalar
+// SingleSimplex, SinglePerlin and SingleValue 3D functions in the same order,
+// without fused multiply-add, so they return the same values.
+
+#ifndef FASTNOISEBATCH_H
+#define FASTNOISEBATCH_H
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FN_BATCH_X86 1
+#else
+#define FN_BATCH_X86 0
+#endif
+
+namespace FastNoiseBatch
+{
+	// lookup tables of the FastNoise instance, the permutation tables are
+	// widened to 32 bits so they can be gathered
+	struct Tables
+	{
+		const int* perm;
+		const int* perm12;
+		const float* gradX;
+		const float* gradY;
+		const float* gradZ;
+		const float* valLut;
+	};
+
+	// out[i] = noise(x[i] * frequency, y[i] * frequency, z[i] * frequency)
+	// interp is a FastNoise::Interp value, ignored by the simplex kernel
+	typedef void (*Kernel)(const Tables& tables, int interp, float frequency,
+		const float* x, const float* y, const float* z, float* out, int count);
+
+	struct Kernels
+	{
+		Kernel simplex;
+		Kernel perlin;
+		Kernel value;
+	};
+
+	// return nullptr when the kernels are not compiled for this platform
+	const Kernels* GetKernelsSSE2();
+	const Kernels* GetKernelsAVX2();
+	const Kernels* GetKernelsAVX512();
+}
+
+#endif
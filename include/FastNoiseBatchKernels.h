@@ -0,0 +1,254 @@
+// FastNoiseBatchKernels.h
+//
+// Vector implementations of the 3D simplex, Perlin and value noises, written
+// once against a small set of operations (V) provided by each instruction set:
+//
+//   F, I, M            float vector, int vector and comparison mask types
+//   Width              number of lanes
+//   Load, Store        unaligned float loads and stores
+//   Set1, SetI         broadcast a float / an int
+//   Add, Sub, Mul      float arithmetic
+//   AddI, AndI         int arithmetic
+//   CvtIF              int to float conversion
+//   Floor              FastFloor of each lane
+//   CmpLt, CmpGe       ordered comparisons
+//   MaskAnd, MaskOr, MaskNot, MaskAndNot (MaskAndNot(a, b) = !a & b)
+//   Select(m, a, b)    a where m is set, b elsewhere
+//   OneIfI, OneIfF     1 (int / float) where the mask is set, 0 elsewhere
+//   GatherI, GatherF   table lookups
+//
+// Included by the FastNoiseBatch_<isa>.cpp files after the definition of their
+// operations, everything lives in an anonymous namespace so each instruction
+// set gets its own copy of the kernels.
+
+#ifndef FASTNOISEBATCHKERNELS_H
+#define FASTNOISEBATCHKERNELS_H
+
+#include "FastNoiseBatch.h"
+
+namespace
+{
+	using FastNoiseBatch::Tables;
+
+	// Interp values of FastNoise
+	const int INTERP_LINEAR = 0;
+	const int INTERP_HERMITE = 1;
+
+	template<class V>
+	inline typename V::I Hash256(const Tables& tables, typename V::I x, typename V::I y, typename V::I z)
+	{
+		typename V::I mask = V::SetI(0xff);
+		typename V::I h = V::GatherI(tables.perm, V::AndI(z, mask));
+		h = V::GatherI(tables.perm, V::AddI(V::AndI(y, mask), h));
+		return V::GatherI(tables.perm, V::AddI(V::AndI(x, mask), h));
+	}
+
+	template<class V>
+	inline typename V::I Hash12(const Tables& tables, typename V::I x, typename V::I y, typename V::I z)
+	{
+		typename V::I mask = V::SetI(0xff);
+		typename V::I h = V::GatherI(tables.perm, V::AndI(z, mask));
+		h = V::GatherI(tables.perm, V::AddI(V::AndI(y, mask), h));
+		return V::GatherI(tables.perm12, V::AddI(V::AndI(x, mask), h));
+	}
+
+	template<class V>
+	inline typename V::F GradCoord(const Tables& tables, typename V::I x, typename V::I y, typename V::I z,
+		typename V::F xd, typename V::F yd, typename V::F zd)
+	{
+		typename V::I lutPos = Hash12<V>(tables, x, y, z);
+
+		return V::Add(V::Add(V::Mul(xd, V::GatherF(tables.gradX, lutPos)),
+		                     V::Mul(yd, V::GatherF(tables.gradY, lutPos))),
+		                     V::Mul(zd, V::GatherF(tables.gradZ, lutPos)));
+	}
+
+	template<class V>
+	inline typename V::F Lerp(typename V::F a, typename V::F b, typename V::F t)
+	{
+		return V::Add(a, V::Mul(t, V::Sub(b, a)));
+	}
+
+	template<class V>
+	inline typename V::F InterpFunc(int interp, typename V::F t)
+	{
+		if (interp == INTERP_LINEAR)
+			return t;
+
+		if (interp == INTERP_HERMITE)
+			return V::Mul(V::Mul(t, t), V::Sub(V::Set1(3), V::Mul(V::Set1(2), t)));
+
+		typename V::F inner = V::Add(V::Mul(t, V::Sub(V::Mul(t, V::Set1(6)), V::Set1(15))), V::Set1(10));
+		return V::Mul(V::Mul(V::Mul(t, t), t), inner);
+	}
+
+	template<class V>
+	inline typename V::F SimplexContribution(const Tables& tables, typename V::I i, typename V::I j, typename V::I k,
+		typename V::F x, typename V::F y, typename V::F z)
+	{
+		typename V::F zero = V::Set1(0);
+		typename V::F t = V::Sub(V::Sub(V::Sub(V::Set1(0.6f), V::Mul(x, x)), V::Mul(y, y)), V::Mul(z, z));
+		typename V::M outside = V::CmpLt(t, zero);
+
+		t = V::Mul(t, t);
+		typename V::F n = V::Mul(V::Mul(t, t), GradCoord<V>(tables, i, j, k, x, y, z));
+
+		return V::Select(outside, zero, n);
+	}
+
+	template<class V>
+	inline typename V::F Simplex(const Tables& tables, int, typename V::F x, typename V::F y, typename V::F z)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+		typedef typename V::M M;
+
+		const float F3 = 1 / float(3);
+		const float G3 = 1 / float(6);
+
+		F t = V::Mul(V::Add(V::Add(x, y), z), V::Set1(F3));
+		I i = V::Floor(V::Add(x, t));
+		I j = V::Floor(V::Add(y, t));
+		I k = V::Floor(V::Add(z, t));
+
+		t = V::Mul(V::CvtIF(V::AddI(V::AddI(i, j), k)), V::Set1(G3));
+		F x0 = V::Sub(x, V::Sub(V::CvtIF(i), t));
+		F y0 = V::Sub(y, V::Sub(V::CvtIF(j), t));
+		F z0 = V::Sub(z, V::Sub(V::CvtIF(k), t));
+
+		// branchless version of the simplex corner ordering of SingleSimplex
+		M xy = V::CmpGe(x0, y0);
+		M yz = V::CmpGe(y0, z0);
+		M xz = V::CmpGe(x0, z0);
+
+		M i1 = V::MaskAnd(xy, xz);
+		M j1 = V::MaskAndNot(xy, yz);
+		M k1 = V::MaskNot(V::MaskOr(yz, i1));
+		M i2 = V::MaskOr(xy, V::MaskAnd(yz, xz));
+		M j2 = V::MaskOr(V::MaskNot(xy), yz);
+		M k2 = V::MaskOr(V::MaskNot(yz), V::MaskNot(V::MaskOr(xy, xz)));
+
+		F x1 = V::Add(V::Sub(x0, V::OneIfF(i1)), V::Set1(G3));
+		F y1 = V::Add(V::Sub(y0, V::OneIfF(j1)), V::Set1(G3));
+		F z1 = V::Add(V::Sub(z0, V::OneIfF(k1)), V::Set1(G3));
+		F x2 = V::Add(V::Sub(x0, V::OneIfF(i2)), V::Set1(2 * G3));
+		F y2 = V::Add(V::Sub(y0, V::OneIfF(j2)), V::Set1(2 * G3));
+		F z2 = V::Add(V::Sub(z0, V::OneIfF(k2)), V::Set1(2 * G3));
+		F x3 = V::Add(V::Sub(x0, V::Set1(1)), V::Set1(3 * G3));
+		F y3 = V::Add(V::Sub(y0, V::Set1(1)), V::Set1(3 * G3));
+		F z3 = V::Add(V::Sub(z0, V::Set1(1)), V::Set1(3 * G3));
+
+		I one = V::SetI(1);
+
+		F n0 = SimplexContribution<V>(tables, i, j, k, x0, y0, z0);
+		F n1 = SimplexContribution<V>(tables, V::AddI(i, V::OneIfI(i1)), V::AddI(j, V::OneIfI(j1)), V::AddI(k, V::OneIfI(k1)), x1, y1, z1);
+		F n2 = SimplexContribution<V>(tables, V::AddI(i, V::OneIfI(i2)), V::AddI(j, V::OneIfI(j2)), V::AddI(k, V::OneIfI(k2)), x2, y2, z2);
+		F n3 = SimplexContribution<V>(tables, V::AddI(i, one), V::AddI(j, one), V::AddI(k, one), x3, y3, z3);
+
+		return V::Mul(V::Set1(32), V::Add(V::Add(V::Add(n0, n1), n2), n3));
+	}
+
+	template<class V>
+	inline typename V::F Perlin(const Tables& tables, int interp, typename V::F x, typename V::F y, typename V::F z)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+
+		I one = V::SetI(1);
+
+		I x0 = V::Floor(x);
+		I y0 = V::Floor(y);
+		I z0 = V::Floor(z);
+		I x1 = V::AddI(x0, one);
+		I y1 = V::AddI(y0, one);
+		I z1 = V::AddI(z0, one);
+
+		F xd0 = V::Sub(x, V::CvtIF(x0));
+		F yd0 = V::Sub(y, V::CvtIF(y0));
+		F zd0 = V::Sub(z, V::CvtIF(z0));
+		F xd1 = V::Sub(xd0, V::Set1(1));
+		F yd1 = V::Sub(yd0, V::Set1(1));
+		F zd1 = V::Sub(zd0, V::Set1(1));
+
+		F xs = InterpFunc<V>(interp, xd0);
+		F ys = InterpFunc<V>(interp, yd0);
+		F zs = InterpFunc<V>(interp, zd0);
+
+		F xf00 = Lerp<V>(GradCoord<V>(tables, x0, y0, z0, xd0, yd0, zd0), GradCoord<V>(tables, x1, y0, z0, xd1, yd0, zd0), xs);
+		F xf10 = Lerp<V>(GradCoord<V>(tables, x0, y1, z0, xd0, yd1, zd0), GradCoord<V>(tables, x1, y1, z0, xd1, yd1, zd0), xs);
+		F xf01 = Lerp<V>(GradCoord<V>(tables, x0, y0, z1, xd0, yd0, zd1), GradCoord<V>(tables, x1, y0, z1, xd1, yd0, zd1), xs);
+		F xf11 = Lerp<V>(GradCoord<V>(tables, x0, y1, z1, xd0, yd1, zd1), GradCoord<V>(tables, x1, y1, z1, xd1, yd1, zd1), xs);
+
+		F yf0 = Lerp<V>(xf00, xf10, ys);
+		F yf1 = Lerp<V>(xf01, xf11, ys);
+
+		return Lerp<V>(yf0, yf1, zs);
+	}
+
+	template<class V>
+	inline typename V::F Value(const Tables& tables, int interp, typename V::F x, typename V::F y, typename V::F z)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+
+		I one = V::SetI(1);
+
+		I x0 = V::Floor(x);
+		I y0 = V::Floor(y);
+		I z0 = V::Floor(z);
+		I x1 = V::AddI(x0, one);
+		I y1 = V::AddI(y0, one);
+		I z1 = V::AddI(z0, one);
+
+		F xs = InterpFunc<V>(interp, V::Sub(x, V::CvtIF(x0)));
+		F ys = InterpFunc<V>(interp, V::Sub(y, V::CvtIF(y0)));
+		F zs = InterpFunc<V>(interp, V::Sub(z, V::CvtIF(z0)));
+
+		const float* lut = tables.valLut;
+
+		F xf00 = Lerp<V>(V::GatherF(lut, Hash256<V>(tables, x0, y0, z0)), V::GatherF(lut, Hash256<V>(tables, x1, y0, z0)), xs);
+		F xf10 = Lerp<V>(V::GatherF(lut, Hash256<V>(tables, x0, y1, z0)), V::GatherF(lut, Hash256<V>(tables, x1, y1, z0)), xs);
+		F xf01 = Lerp<V>(V::GatherF(lut, Hash256<V>(tables, x0, y0, z1)), V::GatherF(lut, Hash256<V>(tables, x1, y0, z1)), xs);
+		F xf11 = Lerp<V>(V::GatherF(lut, Hash256<V>(tables, x0, y1, z1)), V::GatherF(lut, Hash256<V>(tables, x1, y1, z1)), xs);
+
+		F yf0 = Lerp<V>(xf00, xf10, ys);
+		F yf1 = Lerp<V>(xf01, xf11, ys);
+
+		return Lerp<V>(yf0, yf1, zs);
+	}
+
+	// evaluates a noise over arrays, the last partial vector goes through
+	// a zero padded copy so every sample is computed by the vector code
+	template<class V, typename V::F (*Noise)(const Tables&, int, typename V::F, typename V::F, typename V::F)>
+	void Run(const Tables& tables, int interp, float frequency,
+		const float* x, const float* y, const float* z, float* out, int count)
+	{
+		typename V::F freq = V::Set1(frequency);
+
+		int i = 0;
+		for (; i + V::Width <= count; i += V::Width)
+		{
+			V::Store(out + i, Noise(tables, interp, V::Mul(V::Load(x + i), freq), V::Mul(V::Load(y + i), freq), V::Mul(V::Load(z + i), freq)));
+		}
+
+		if (i < count)
+		{
+			float px[V::Width] = {}, py[V::Width] = {}, pz[V::Width] = {}, po[V::Width];
+			int rest = count - i;
+
+			for (int u = 0; u < rest; u++)
+			{
+				px[u] = x[i + u];
+				py[u] = y[i + u];
+				pz[u] = z[i + u];
+			}
+
+			V::Store(po, Noise(tables, interp, V::Mul(V::Load(px), freq), V::Mul(V::Load(py), freq), V::Mul(V::Load(pz), freq)));
+
+			for (int u = 0; u < rest; u++)
+				out[i + u] = po[u];
+		}
+	}
+}
+
+#endif
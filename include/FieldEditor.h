@@ -0,0 +1,133 @@
+#ifndef FIELDEDITOR_H
+#define FIELDEDITOR_H
+
+#include <CellGrid.h>
+#include <Mesh.h>
+#include <VertexFormat.h>
+#include <ThreadPool.h>
+#include <vec3d.h>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Scalar field edited by brushes and kept meshed brick by brick.
+// The cubes are split in bricks of BRICK_SIZE^3 cubes, each brick is meshed
+// on its own and stored in its own slot of a single vertex buffer and a
+// single 32 bit index buffer. An edit marks dirty the bricks of the cubes
+// whose nodes have one of the edited cells as value or as neighbour in
+// their gradient, and update() remeshes only them and rewrites their slots
+// in place. The slots have some spare room, the unused indices of a slot are
+// degenerate triangles so the whole index buffer can be drawn at once.
+// The vertices are placed as those of a CubeGrid built from the whole field,
+// their normals are the gradient of the field with central differences
+// across the brick faces.
+
+class FieldEditor
+{
+    public:
+        static constexpr int BRICK_SIZE = 8;
+
+        // part [first, first + count) of a buffer
+        struct Range
+        {
+            size_t first, count;
+        };
+
+        // durations of the steps of the last update call, in milliseconds
+        struct Timings
+        {
+            double remesh, patch;
+        };
+
+        CellGrid field;
+        float cubeSize = 0.1f;
+        float surfaceLevel = 0.5f;
+
+        // packed vertices (VertexFormat::PositionFloat32 and the normals encoding)
+        // and their triangles
+        VertexFormat format;
+        vector<uint8_t> vertexData;
+        vector<uint32_t> indices;
+
+        // changes of the buffers since the last clearChanges call : either the
+        // buffers were reallocated, or the listed vertices and indices were rewritten
+        bool buffersResized = false;
+        vector<Range> changedVertices;
+        vector<Range> changedIndices;
+
+        Timings timings = {};
+
+        // threadCount <= 0 uses the number of hardware threads
+        FieldEditor(VertexFormat::NormalEncoding normal = VertexFormat::NormalFloat32, int threadCount = 0);
+        FieldEditor(const FieldEditor&) = delete;
+        FieldEditor& operator = (const FieldEditor&) = delete;
+
+        // Starts editing a copy of grid, every brick is dirty until the next update
+        void build(const CellGrid& grid, float _cubeSize, float _surfaceLevel);
+
+        // brushes : the values inside the sphere change by strength at its
+        // center, fading to 0 on its surface, and by strength in the whole box
+        void addSphere(const vec3d& center, float radius, float strength);
+        void subtractSphere(const vec3d& center, float radius, float strength);
+        void addBox(const vec3d& minCorner, const vec3d& maxCorner, float strength);
+        void subtractBox(const vec3d& minCorner, const vec3d& maxCorner, float strength);
+        // moves the values inside the sphere towards the mean of their neighbours,
+        // strength in [0, 1] being the fraction of the way at the center
+        void smooth(const vec3d& center, float radius, float strength);
+
+        // Remeshes the dirty bricks and patches their slots, returns their number
+        int update();
+        void clearChanges();
+
+        size_t getVertexCount() const { return vertexData.size() / format.stride(); }
+        size_t getDirtyBrickCount() const { return dirtyBricks.size(); }
+
+        virtual ~FieldEditor();
+
+    protected:
+
+    private:
+        // slot of a brick in the buffers, in vertices and indices
+        struct Brick
+        {
+            size_t firstVertex, vertexCount, vertexCapacity;
+            size_t firstIndex, indexCount, indexCapacity;
+            bool dirty;
+        };
+
+        int bricksX = 0;
+        int bricksY = 0;
+        int bricksZ = 0;
+        vector<Brick> bricks;
+        vector<int> dirtyBricks;
+        // room of the slots left behind by the bricks moved to bigger ones
+        size_t wastedVertices = 0;
+        size_t wastedIndices = 0;
+
+        ThreadPool pool;
+
+        // cell coordinate along an axis of size cells of a position coordinate
+        float cellCoordinate(float x, int size) const;
+        vec3d cellPosition(int i, int j, int k) const;
+        // cells range [first, last] covering [minCorner, maxCorner], false if empty
+        bool cellRange(const vec3d& minCorner, const vec3d& maxCorner, int first[3], int last[3]) const;
+        // marks dirty the bricks whose vertices or normals depend on one of
+        // the cells [first, last]
+        void markDirty(const int first[3], const int last[3]);
+        void applySphere(const vec3d& center, float radius, float strength);
+        void applyBox(const vec3d& minCorner, const vec3d& maxCorner, float strength);
+        // meshes a brick from a copy of its nodes, and of one more node around
+        // them for the normals, positioned in the field
+        void meshBrick(int brick, Mesh& mesh) const;
+        // writes the mesh of a brick in its slot, moving it to the end of the
+        // buffers when it doesn't fit
+        void patchBrick(int brick, const Mesh& mesh);
+        // fills the unused indices of a slot with degenerate triangles
+        void padIndices(const Brick& brick);
+        // packs the slots one after the other, dropping the abandoned ones
+        void compact();
+};
+
+#endif // FIELDEDITOR_H
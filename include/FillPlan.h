@@ -0,0 +1,56 @@
+#ifndef FILLPLAN_H
+#define FILLPLAN_H
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Everything CellGrid::fillGrid needs that doesn't depend on the cell :
+// the frequency and amplitude of each octave, and the closed edges weight
+// along each axis, the weight of a cell being the max of its 3 axis weights.
+
+class FillPlan
+{
+    public:
+        int width = 0;
+        int height = 0;
+        int depth = 0;
+        int octaves = 0;
+
+        // frequency of each octave : lacunarity^u * scale
+        vector<float> frequencies;
+        // amplitude of each octave : persistance^u, kept in double as the
+        // octaves have always been summed with a double amplitude
+        vector<double> amplitudes;
+        // global coordinates of the cell (0, 0, 0) : the noise is sampled at the
+        // coordinates of the cell plus the origin, so grids filled with adjacent
+        // origins continue each other
+        int originX = 0;
+        int originY = 0;
+        int originZ = 0;
+        // closed edges weight along each axis, clamped to [0, 1], all 0
+        // when the edges are open
+        vector<float> weightX;
+        vector<float> weightY;
+        vector<float> weightZ;
+
+        FillPlan();
+        // closedEdges : push the values of the outer cells below any surface level so
+        // the surface is closed, false for grids continued by other grids
+        FillPlan(int _width, int _height, int _depth, int _octaves, float lacunarity, float persistance, float scale,
+                 bool closedEdges = true);
+
+        // closed edges weight of the cell (i, j, k)
+        float weight(int i, int j, int k) const { return max(weightX[i], max(weightY[j], weightZ[k])); }
+
+        virtual ~FillPlan();
+
+    protected:
+
+    private:
+        // weight of each position along an axis of the given size
+        static vector<float> axisWeights(int size);
+};
+
+#endif // FILLPLAN_H
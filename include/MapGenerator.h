@@ -0,0 +1,85 @@
+#ifndef MAPGENERATOR_H
+#define MAPGENERATOR_H
+
+#include <FastNoise.h>
+#include <CellGrid.h>
+#include <CubeGrid.h>
+#include <Mesh.h>
+#include <ThreadPool.h>
+#include <MemoryTracker.h>
+#include <cstddef>
+
+using namespace std;
+
+// Runs the whole generation of a map : fills the scalar field with noise,
+// builds the cube grid from it and marches the cubes into a mesh.
+// It has no graphics dependency so it can be used without a window.
+
+class MapGenerator
+{
+    public:
+        // durations of the generation steps, in milliseconds
+        struct Timings
+        {
+            double fillGrid, generateGrid, generateMesh, optimizeMesh, total;
+        };
+
+        // heap use of the generation steps, only measured when the allocations
+        // are tracked (see MemoryTracker), and bytes held by the data structures
+        // at the end of the step creating them
+        struct Memory
+        {
+            MemoryTracker::Usage fillGrid, generateGrid, generateMesh, optimizeMesh;
+            size_t cellGridBytes, nodeBytes, meshBytes;
+        };
+
+        // 3D scalar grid size
+        int gridWidth = 50;
+        int gridHeight = 50;
+        int gridDepth = 50;
+
+        // noise function parameters
+        int octaves = 3;
+        float lacunarity = 2.f;
+        float persistance = 0.5f;
+        float noiseScale = 3.f;
+
+        // cube grid parameters
+        float surfaceLevel = 0.5f;
+        float cubeSize = 0.1f;
+        unsigned int minRegionSize = 1000;
+
+        Mesh::NormalMode normalMode = Mesh::FaceAverage;
+        // reorder the triangles and vertices of the mesh for the GPU vertex cache
+        bool optimizeMesh = true;
+
+        FastNoise noise;
+        Mesh mesh;
+        Timings timings;
+        Memory memory;
+        // vertex cache efficiency of the mesh before and after its optimization
+        Mesh::CacheStatistics cacheBefore, cacheAfter;
+
+        // threadCount <= 0 uses the number of hardware threads
+        MapGenerator(int threadCount = 0);
+        MapGenerator(const MapGenerator&) = delete;
+        MapGenerator& operator = (const MapGenerator&) = delete;
+
+        int getThreadCount() const { return pool.getThreadCount(); }
+        // scalar field of the last generated map
+        const CellGrid& getCellGrid() const { return cellGrid; }
+
+        // generate a new mesh with the given noise seed
+        void generate(int seed);
+
+        virtual ~MapGenerator();
+
+    protected:
+
+    private:
+        ThreadPool pool;
+        CellGrid cellGrid;
+        CubeGrid cubeGrid;
+};
+
+#endif // MAPGENERATOR_H
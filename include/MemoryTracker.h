@@ -0,0 +1,72 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include <cstddef>
+
+using namespace std;
+
+// Heap allocation counters, used to measure the memory of each generation step.
+//
+// The counters are only updated when MC_TRACK_MEMORY is defined
+// (MC_ENABLE_MEMORY_TRACKING in CMake) : the global operator new and delete
+// are then replaced to count every allocation of the program, from any
+// thread. Otherwise they stay at zero and nothing is replaced.
+
+class MemoryTracker
+{
+    public:
+        struct Counters
+        {
+            // bytes currently allocated and highest value since the last resetPeak
+            size_t liveBytes;
+            size_t peakBytes;
+            // totals since the start of the program
+            size_t allocatedBytes;
+            size_t allocationCount;
+        };
+
+        // heap use of a step, measured by MemoryMeasure
+        struct Usage
+        {
+            // bytes and number of allocations made during the step
+            size_t allocatedBytes;
+            size_t allocationCount;
+            // highest number of bytes allocated at once during the step
+            size_t peakBytes;
+            // bytes still allocated after the step minus the ones before it,
+            // negative when the step freed more than it kept
+            long long retainedBytes;
+        };
+
+        // true if the allocations are counted
+        static bool enabled();
+        static Counters counters();
+        // restart the peak from the current live bytes
+        static void resetPeak();
+        // peak resident set size of the whole process, 0 where unknown
+        static size_t peakResidentBytes();
+
+        // used by the replaced operators
+        static void recordAllocation(size_t size);
+        static void recordRelease(size_t size);
+
+    protected:
+
+    private:
+        MemoryTracker() = delete;
+};
+
+// Measures the heap use between its construction and finish. It resets the
+// peak of the tracker, so measures can follow each other but not be nested.
+
+class MemoryMeasure
+{
+    public:
+        MemoryMeasure();
+        MemoryTracker::Usage finish() const;
+
+    private:
+        MemoryTracker::Counters start;
+};
+
+#endif // MEMORYTRACKER_H
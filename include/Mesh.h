@@ -2,13 +2,16 @@
 #define MESH_H
 
 #include <vector>
-#include <list>
+#include <string>
 #include <vec3d.h>
 #include <Cube.h>
 #include <CubeGrid.h>
 #include <Vertex.h>
 #include <Triangle.h>
-#include <set>
+#include <ThreadPool.h>
+#include <VertexFormat.h>
+#include <cstddef>
+#include <cstdint>
 
 using namespace std;
 
@@ -18,32 +21,118 @@ using namespace std;
 class Mesh
 {
     public:
+        // how the vertex normals are calculated :
+        // - FaceAverage : average of the unit normals of the triangles sharing the
+        //   vertex, from the sharedTriangles adjacency
+        // - AreaWeighted : sum of the normals of the triangles sharing the vertex
+        //   weighted by their area, accumulated while the triangles are created
+        //   without any adjacency (sharedTriangles stays empty)
+        // - FieldGradient : opposite of the gradient of the scalar field at the
+        //   vertex, smoother and independent of the triangulation
+        // - NoNormals : the normals are left null for the caller to set, e.g.
+        //   with calculateGradientNormals from a field bigger than the grid
+        enum NormalMode { FaceAverage, AreaWeighted, FieldGradient, NoNormals };
+
+        // part of the mesh drawable with 16 bit indices : the indices
+        // [firstIndex, firstIndex + indexCount) refer to the vertices
+        // [firstVertex, firstVertex + vertexCount) of the chunk vertex list
+        struct Chunk
+        {
+            unsigned int firstVertex, vertexCount;
+            unsigned int firstIndex, indexCount;
+            // bounding box of the chunk vertices, for culling
+            vec3d boundsMin, boundsMax;
+        };
+
+        // chunk limits of a meshlet, small enough for a mesh shader workgroup
+        static const unsigned int MESHLET_VERTICES = 64;
+        static const unsigned int MESHLET_TRIANGLES = 124;
+
+        // post-transform vertex cache efficiency of the triangle order :
+        // - acmr : average cache miss ratio, transformed vertices per triangle
+        //   (0.5 at best for a large regular mesh, 3 at worst)
+        // - atvr : average transformed vertex ratio, transformed vertices per
+        //   used vertex (1 at best)
+        struct CacheStatistics
+        {
+            float acmr, atvr;
+        };
+
+        // durations of the steps of the last generateMesh call, in milliseconds
+        struct Timings
+        {
+            double marchCubes, ignoreSmallRegions, adjacency, normals;
+        };
+
         float dimX, dimY, dimZ;
+        NormalMode normalMode = FaceAverage;
+        Timings timings = {};
         vector<Vertex> vertices;
         vector<Triangle> triangles;
-        vector<list<unsigned int>> sharedTriangles;
+        // triangles sharing each vertex, in compressed sparse row form : the
+        // triangles of the vertex v are sharedTriangles[sharedOffsets[v]] to
+        // sharedTriangles[sharedOffsets[v+1] - 1], in increasing order
+        vector<unsigned int> sharedOffsets;
+        vector<unsigned int> sharedTriangles;
 
         Mesh();
-        void generateMesh(CubeGrid& cubeGrid, unsigned int minTriangleCount);
+        // inPlace : count the vertices and triangles before creating them so they
+        // are stored without reallocations (see CubeGrid::marchCubesInPlace)
+        void generateMesh(CubeGrid& cubeGrid, unsigned int minTriangleCount, bool inPlace = false);
+        // same as above, the cubes are marched in parallel on the pool
+        void generateMesh(CubeGrid& cubeGrid, unsigned int minTriangleCount, ThreadPool& pool);
         void clear();
+        // set the normal of each vertex from the gradient of the node field, the
+        // nodes being centered on center instead of the origin. A field bigger
+        // than the marched one gives central differences on its border.
+        void calculateGradientNormals(const NodeField& nodes, const vec3d& center = vec3d());
+        // bytes allocated for the vertices, the triangles and the shared triangles lists
+        size_t memorySize() const;
         // get the vertex and indices arrays to load in the buffers
         float* getVertexArray();
+        // size in bytes of the vertices packed in the given format
+        size_t getPackedVertexSize(const VertexFormat& format) const;
+        // write the vertices interleaved in the given format into buffer (e.g. a
+        // mapped vertex buffer), which must hold getPackedVertexSize(format) bytes
+        void packVertices(const VertexFormat& format, void *buffer) const;
+        // same as above for the vertices of the given indices, in that order
+        void packVertices(const VertexFormat& format, void *buffer, const vector<unsigned int>& vertexIds) const;
         unsigned int* getTriangleArray();
+        // split the triangles, in order, into chunks of at most maxVertices
+        // (<= 65536) vertices and maxTriangles triangles with 16 bit indices.
+        // chunkVertices receives the mesh vertex index of each chunk vertex, the
+        // vertices shared by several chunks are repeated in each of them
+        void splitChunks(unsigned int maxVertices, unsigned int maxTriangles, vector<Chunk>& chunks, vector<unsigned int>& chunkVertices, vector<uint16_t>& indices) const;
+        // reorder the triangles so the GPU post-transform cache is reused
+        // more, for a cache of cacheSize vertices
+        void optimizeVertexCache(unsigned int cacheSize = 32);
+        // renumber the vertices in their first use order by the triangles and
+        // drop the unused ones, best done after optimizeVertexCache
+        void optimizeVertexFetch();
+        // cache efficiency of the triangles for a FIFO cache of cacheSize vertices
+        CacheStatistics getCacheStatistics(unsigned int cacheSize = 32) const;
+        // write the positions, normals and triangles to a Wavefront OBJ file or a
+        // binary little endian PLY file, false if the file couldn't be written
+        bool writeObj(const string& path) const;
+        bool writePly(const string& path) const;
         virtual ~Mesh();
 
     protected:
 
     private:
-        // create the triangles of a cube according to its configuration
-        void triangulateCube(Cube& cube);
+        // filter small regions and calculate the normals of the marched triangles
+        void processTriangles(CubeGrid& cubeGrid, unsigned int minTriangleCount, bool normalsAccumulated);
         void calculateNormals();
+        // add the area weighted normal of each triangle to its vertices
+        void accumulateNormals();
+        void normalizeNormals();
         // create an adjacency list of the shared triangles by each vertex
         void assignSharedTriangles();
-        // remove triangles that are part of small unwanted subshapes
+        // remove triangles that are part of small unwanted subshapes, and
+        // the vertices they leave unused
         void ignoreSmallRegions(unsigned int minTriangleCount);
-        // utility method for the ignoreSmallRegions method : apply floodfill to get
-        // triangles belonging to a same region starting from a given vertex
-        void getRegionTriangles(int startVertex, bool *visited, set<int>& regionTriangles);
+        // write a vertex in the given format at output
+        void packVertex(const VertexFormat& format, const Vertex& vertex, unsigned char *output) const;
 };
 
 #endif // MESH_H
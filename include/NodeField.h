@@ -0,0 +1,97 @@
+#ifndef NODEFIELD_H
+#define NODEFIELD_H
+
+#include <vec3d.h>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// control nodes (i.e. cube vertices) stored as a structure of arrays :
+// one value per node and one bit per node telling if it is active.
+// The position of a node is implicit from its coordinates, nodes are
+// centered around the origin and spaced by nodeSize.
+// Nodes are stored x first then y then z, so a z slice is contiguous.
+
+class NodeField
+{
+    public:
+        int width = 0;
+        int height = 0;
+        int depth = 0;
+        float nodeSize = 0.f;
+        vector<float> values;
+        vector<uint64_t> activeBits;
+
+        NodeField();
+        NodeField(int _width, int _height, int _depth, float _nodeSize);
+        // the declared destructor removes the implicit moves, without them
+        // assigning a temporary copies it and keeps the previous buffers
+        NodeField(const NodeField&) = default;
+        NodeField(NodeField&&) = default;
+        NodeField& operator = (const NodeField&) = default;
+        NodeField& operator = (NodeField&&) = default;
+
+        size_t index(int i, int j, int k) const { return ((size_t)k * height + j) * width + i; }
+        size_t size() const { return values.size(); }
+        // bytes allocated for the values and the active bits
+        size_t memorySize() const { return values.capacity() * sizeof(float) + activeBits.capacity() * sizeof(uint64_t); }
+
+        float& value(int i, int j, int k) { return values[index(i, j, k)]; }
+        float value(int i, int j, int k) const { return values[index(i, j, k)]; }
+
+        bool isActive(size_t n) const { return (activeBits[n >> 6] >> (n & 63)) & 1; }
+        bool isActive(int i, int j, int k) const { return isActive(index(i, j, k)); }
+        void setActive(size_t n, bool active);
+        void setActive(int i, int j, int k, bool active) { setActive(index(i, j, k), active); }
+        // set the state of the nodes [first, last)
+        void setActive(size_t first, size_t last, bool active);
+        // first active (or inactive) node in [n, end), end if there is none
+        size_t nextActive(size_t n, size_t end) const;
+        size_t nextInactive(size_t n, size_t end) const;
+
+        vec3d position(int i, int j, int k) const;
+        // true if the edge starting from the node n along axis (0 : x, 1 : y, 2 : z)
+        // crosses the surface, i.e. its two nodes have different states
+        bool crosses(size_t n, int axis) const;
+        // vertex where the surface crosses the edge starting from the node (i, j, k)
+        // along axis, linearly interpolated between the values of its two nodes
+        vec3d edgeVertex(int i, int j, int k, int axis, float surfaceLevel) const;
+        // gradient at a vertex on an edge, in value per node : the central
+        // differences at the two nodes of the edge, interpolated along it.
+        // The differences are one sided on the border of the field.
+        vec3d gradient(const vec3d& pos) const;
+        // central differences of the values at the node (i, j, k)
+        vec3d nodeGradient(int i, int j, int k) const;
+
+        virtual ~NodeField();
+
+    protected:
+
+    private:
+};
+
+inline void NodeField::setActive(size_t n, bool active)
+{
+    uint64_t bit = (uint64_t)1 << (n & 63);
+    if(active)
+        activeBits[n >> 6] |= bit;
+    else
+        activeBits[n >> 6] &= ~bit;
+}
+
+inline vec3d NodeField::position(int i, int j, int k) const
+{
+    return vec3d(-width*nodeSize/2.f + i*nodeSize + nodeSize/2.f,
+                 -height*nodeSize/2.f + j*nodeSize + nodeSize/2.f,
+                 -depth*nodeSize/2.f + k*nodeSize + nodeSize/2.f);
+}
+
+inline bool NodeField::crosses(size_t n, int axis) const
+{
+    size_t next = axis == 0 ? n + 1 : axis == 1 ? n + width : n + (size_t)width * height;
+    return isActive(n) != isActive(next);
+}
+
+#endif // NODEFIELD_H
@@ -1,8 +1,16 @@
 #ifndef TABLE_H_INCLUDED
 #define TABLE_H_INCLUDED
 
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+// The tables are inline constexpr (C++17) : they are emitted once for the
+// whole program instead of once per translation unit including them.
+
 // triangulation table from : http://paulbourke.net/geometry/polygonise/
-static const int triTable[256][16] =
+inline constexpr int triTable[256][16] =
 {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
 {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
 {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
@@ -260,4 +268,72 @@ static const int triTable[256][16] =
 {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
 {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
 
+// Companion tables derived from the triangulation table at compile time
+
+constexpr array<uint16_t, 256> makeEdgeTable()
+{
+    array<uint16_t, 256> edges = {};
+
+    for(int configuration = 0; configuration < 256; configuration++){
+        for(int n = 0; triTable[configuration][n] != -1; n++){
+            edges[configuration] |= 1 << triTable[configuration][n];
+        }
+    }
+
+    return edges;
+}
+
+constexpr array<uint8_t, 256> makeTriangleCounts()
+{
+    array<uint8_t, 256> counts = {};
+
+    for(int configuration = 0; configuration < 256; configuration++){
+        int n = 0;
+        while(triTable[configuration][n] != -1)
+            n++;
+        counts[configuration] = n / 3;
+    }
+
+    return counts;
+}
+
+constexpr array<uint16_t, 257> makeTriangleOffsets()
+{
+    array<uint16_t, 257> offsets = {};
+    array<uint8_t, 256> counts = makeTriangleCounts();
+
+    for(int configuration = 0; configuration < 256; configuration++){
+        offsets[configuration + 1] = offsets[configuration] + counts[configuration] * 3;
+    }
+
+    return offsets;
+}
+
+// 12 bit mask of the edges crossed by the surface for each configuration
+inline constexpr array<uint16_t, 256> edgeTable = makeEdgeTable();
+
+// number of triangles of each configuration
+inline constexpr array<uint8_t, 256> triangleCounts = makeTriangleCounts();
+
+// the triangles of the configuration c are the edges
+// triangleList[triangleOffsets[c]] to triangleList[triangleOffsets[c+1] - 1],
+// three per triangle
+inline constexpr array<uint16_t, 257> triangleOffsets = makeTriangleOffsets();
+
+constexpr array<int8_t, triangleOffsets[256]> makeTriangleList()
+{
+    array<int8_t, triangleOffsets[256]> list = {};
+
+    for(int configuration = 0; configuration < 256; configuration++){
+        for(int n = 0; n < triangleCounts[configuration] * 3; n++){
+            list[triangleOffsets[configuration] + n] = triTable[configuration][n];
+        }
+    }
+
+    return list;
+}
+
+// edges of the triangles of all configurations, without the -1 padding
+inline constexpr array<int8_t, triangleOffsets[256]> triangleList = makeTriangleList();
+
 #endif // TABLE_H_INCLUDED
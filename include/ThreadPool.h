@@ -0,0 +1,67 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+// fixed size pool of worker threads with one task queue per worker.
+// A worker takes the tasks of its own queue from the front and, when it
+// runs out of work, steals from the back of the other queues.
+
+class ThreadPool
+{
+    public:
+        // threadCount <= 0 uses the number of hardware threads
+        ThreadPool(int threadCount = 0);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator = (const ThreadPool&) = delete;
+
+        int getThreadCount() const { return (int)workers.size(); }
+
+        // Calls task(index) for each index in [0, taskCount) and returns once
+        // all calls are done. Indices are dealt to the workers in contiguous
+        // ranges, the calling thread helps by stealing tasks while it waits.
+        void parallelFor(int taskCount, const function<void(int)>& task);
+
+        // Queues task to run on a worker and returns without waiting for it.
+        // The tasks still queued when the pool is destroyed are run before
+        // the workers stop.
+        void submit(function<void()> task);
+
+        virtual ~ThreadPool();
+
+    protected:
+
+    private:
+        struct WorkQueue
+        {
+            mutex lock;
+            deque<function<void()>> tasks;
+        };
+
+        vector<thread> workers;
+        vector<unique_ptr<WorkQueue>> queues;
+
+        mutex wakeLock;
+        condition_variable wakeCondition;
+        atomic<int> queuedTasks;
+        bool stopping = false;
+        // worker receiving the next submitted task
+        atomic<unsigned int> nextWorker;
+
+        void workerLoop(int worker);
+        // pop a task from the front of the worker's queue, or steal one from
+        // the back of another queue, worker < 0 only steals
+        bool takeTask(int worker, function<void()>& task);
+        void push(int worker, function<void()> task);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,74 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// Scoped timing zones recorded per thread, exported as Chrome trace events
+// (chrome://tracing, Perfetto) to see where the time goes in a generation
+// or a frame. Zones nest, the viewer rebuilds the hierarchy from their times.
+//
+// The zones are only recorded when MC_TRACE is defined (MC_ENABLE_TRACE in
+// CMake), otherwise the macros expand to nothing :
+//
+//   TRACE_ZONE("fillGrid");           // records until the end of the scope
+//   TRACE_THREAD_NAME("worker");      // name of the calling thread in the trace
+//
+// Each thread records into its own ring buffer of CAPACITY zones, the oldest
+// zones being overwritten. The buffers are read by writeChromeTrace and
+// cleared by clear, which must be called while no zone is being recorded.
+
+class Trace
+{
+    public:
+        static const size_t CAPACITY = 1 << 15;
+
+        // true if the zones are compiled in
+        static bool enabled();
+        // nanoseconds since the start of the program
+        static int64_t now();
+
+        // add a zone to the buffer of the calling thread, name must outlive the trace
+        static void record(const char *name, int64_t start, int64_t end);
+        static void setThreadName(const char *name);
+
+        // write the recorded zones of all the threads as a Chrome trace JSON file,
+        // false if the file couldn't be written
+        static bool writeChromeTrace(const string& path);
+        // forget the recorded zones
+        static void clear();
+
+    protected:
+
+    private:
+        Trace() = delete;
+};
+
+// records the time between its construction and its destruction
+class TraceZone
+{
+    public:
+        TraceZone(const char *_name) : name(_name), start(Trace::now()) {}
+        TraceZone(const TraceZone&) = delete;
+        TraceZone& operator = (const TraceZone&) = delete;
+        ~TraceZone() { Trace::record(name, start, Trace::now()); }
+
+    private:
+        const char *name;
+        int64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef MC_TRACE
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+#define TRACE_ZONE(name) do {} while(0)
+#define TRACE_THREAD_NAME(name) do {} while(0)
+#endif
+
+#endif // TRACE_H
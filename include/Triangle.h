@@ -7,7 +7,7 @@
 struct Triangle
 {
     unsigned int a, b, c;
-    vec3d normal;
+    Triangle();
     Triangle(unsigned int _a, unsigned int _b, unsigned int _c);
 };
 
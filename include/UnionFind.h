@@ -0,0 +1,52 @@
+#ifndef UNIONFIND_H
+#define UNIONFIND_H
+
+#include <vector>
+
+using namespace std;
+
+// disjoint sets of the elements [0, size), used to label connected regions.
+// Merging two sets always keeps the smallest root, so the labels only
+// depend on the merged pairs and not on the order of the merges.
+
+class UnionFind
+{
+    public:
+        UnionFind();
+        UnionFind(unsigned int size);
+
+        // root of the set containing x, halving the path on the way
+        unsigned int find(unsigned int x);
+        // merge the sets of x and y
+        void unite(unsigned int x, unsigned int y);
+        unsigned int size() const { return (unsigned int)parent.size(); }
+
+        virtual ~UnionFind();
+
+    protected:
+
+    private:
+        vector<unsigned int> parent;
+};
+
+inline unsigned int UnionFind::find(unsigned int x)
+{
+    while(parent[x] != x){
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+inline void UnionFind::unite(unsigned int x, unsigned int y)
+{
+    x = find(x);
+    y = find(y);
+
+    if(x < y)
+        parent[y] = x;
+    else if(y < x)
+        parent[x] = y;
+}
+
+#endif // UNIONFIND_H
@@ -8,6 +8,7 @@ struct Vertex
 {
     vec3d pos;
     vec3d normal;
+    Vertex();
     Vertex(vec3d _pos);
 };
 
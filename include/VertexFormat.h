@@ -0,0 +1,48 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <cstddef>
+
+// Layout of the vertices packed by Mesh::packVertices : the position then
+// the normal of each vertex, interleaved, each vertex padded to 4 bytes.
+// Float normals start on a 4 byte boundary, as graphics APIs require for
+// float attributes : after 16 bit positions, 2 bytes of padding come first
+// (position at 0, normal at 8, stride 20).
+//
+// Positions :
+// - PositionFloat32 : 3 floats
+// - PositionUNorm16 : 3 unsigned shorts relative to the mesh box,
+//   x = (q / 65535 - 0.5) * dimX (same for y and z)
+// Normals :
+// - NormalFloat32 : 3 floats
+// - NormalOct16 / NormalOct8 : 2 signed shorts / bytes, octahedral encoding
+//   of the unit normal mapped to [-1, 1] (see Mesh::packVertices)
+// - NormalNone : no normal
+
+class VertexFormat
+{
+    public:
+        enum PositionEncoding { PositionFloat32, PositionUNorm16 };
+        enum NormalEncoding { NormalFloat32, NormalOct16, NormalOct8, NormalNone };
+
+        PositionEncoding position = PositionFloat32;
+        NormalEncoding normal = NormalFloat32;
+
+        VertexFormat();
+        VertexFormat(PositionEncoding _position, NormalEncoding _normal);
+
+        // size in bytes of the position and of the normal of a vertex
+        size_t positionSize() const;
+        size_t normalSize() const;
+        // offset of the normal in a vertex and distance between two vertices, in bytes
+        size_t normalOffset() const;
+        size_t stride() const;
+
+        virtual ~VertexFormat();
+
+    protected:
+
+    private:
+};
+
+#endif // VERTEXFORMAT_H
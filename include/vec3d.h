@@ -18,6 +18,7 @@ class vec3d
         static float angleBetween(vec3d v1, vec3d v2);
         float length();
         static float distance(vec3d p1, vec3d p2);
+        // leaves a null vector unchanged
         void normalize();
 
         vec3d& operator += (const vec3d& v);
@@ -1,17 +1,25 @@
 #define GLEW_STATIC
 #include <GL/glew.h>
+#if __has_include(<GLFW/glfw3.h>)
+#include <GLFW/glfw3.h>
+#else
 #include <GL/glfw3.h>
+#endif
 
 #include <stdlib.h>
 #include <iostream>
 #include <time.h>
 #include <chrono>
+#include <map>
+#include <deque>
 
-#include <FastNoise.h>
-#include <CubeGrid.h>
-#include <CellGrid.h>
+#include <MapGenerator.h>
+#include <ChunkManager.h>
+#include <FieldEditor.h>
 #include <Mesh.h>
 #include <Camera.h>
+#include <VertexFormat.h>
+#include <Trace.h>
 
 // 3D scalar grid size
 
@@ -32,6 +40,46 @@
 #define CUBE_SIZE       0.1f
 #define MIN_REGION_SIZE 1000
 
+// vertex normals (Mesh::FaceAverage, Mesh::AreaWeighted or Mesh::FieldGradient)
+
+#define NORMAL_MODE     Mesh::FaceAverage
+
+// number of threads used to generate the map (0 : one per hardware thread)
+
+#define THREAD_COUNT    0
+
+// reorder the triangles and vertices of the mesh for the GPU vertex cache
+
+#define OPTIMIZE_MESH   true
+
+// limits of the chunks drawn with 16 bit indices
+// (Mesh::MESHLET_VERTICES and Mesh::MESHLET_TRIANGLES for meshlets)
+
+#define CHUNK_VERTICES  65535
+#define CHUNK_TRIANGLES 0xFFFFFFFF
+
+// stream an unbounded terrain made of chunks around the camera instead of
+// generating a single box, the arrow keys and page up/down move the camera
+
+#define STREAM_TERRAIN  false
+#define CHUNK_SIZE      32
+#define VIEW_DISTANCE   4
+#define MAX_RESIDENT_CHUNKS 512
+// chunks uploaded to the GPU per frame, to keep the frame rate steady
+#define CHUNK_UPLOADS   4
+#define CAM_MOVE_SPEED  3.f
+
+// sculpting brush, applied at the camera center while its key is held :
+// E/R add/subtract a sphere, N/M add/subtract a box, F smooths.
+// The strength is the change of the field per second.
+
+#define BRUSH_RADIUS    0.4f
+#define BRUSH_STRENGTH  2.f
+
+// file where the trace zones are written on exit, when compiled with MC_TRACE
+
+#define TRACE_FILE      "trace.json"
+
 // camera parameters
 
 #define CAM_ROTATION_SPEED  0.5f
@@ -43,20 +91,36 @@
 using namespace std;
 
 
-// generator class instances
-static FastNoise noise;
-static CellGrid cellGrid;
-static CubeGrid cubeGrid;
-static Mesh mesh;
+// generator of the maps, the mesh is generator->mesh
+static MapGenerator *generator;
+// generator of the streamed terrain chunks, only created with STREAM_TERRAIN
+static ChunkManager *streamer = nullptr;
 
 // camera
 static Camera cam;
 
-// vertex array elements params
-static GLuint vbo, ibo;
-static unsigned int vboSize, iboSize;
-static unsigned int normalsOffset;
-static unsigned int iboCount;
+// vertex and index buffers of a mesh, drawn by chunks of 16 bit indices
+struct MeshBuffers
+{
+    GLuint vbo = 0, ibo = 0;
+    vector<Mesh::Chunk> chunks;
+    // translation of the mesh
+    vec3d offset;
+};
+
+// interleaved layout of the vertices in the VBO, the fixed function
+// pipeline only takes float normals so they are not quantized here
+static const VertexFormat vertexFormat(VertexFormat::PositionFloat32, VertexFormat::NormalFloat32);
+// buffers of the box map
+static MeshBuffers box;
+// buffers of the resident terrain chunks, and chunks waiting for their upload
+static map<Coord, MeshBuffers> terrain;
+static deque<Coord> uploads;
+// editor of the box map, drawn instead of the generated mesh once sculpted
+static FieldEditor *editor = nullptr;
+static bool sculpting = false;
+static MeshBuffers sculpted;
+static size_t sculptedIndices;
 
 static float frameTime;
 static bool drawAxes, drawWireBox;
@@ -65,6 +129,18 @@ static bool drawAxes, drawWireBox;
 // generate the mesh by marching cubes
 static void generateMap();
 static void generateBuffers();
+// move the camera center with the held keys
+static void moveCamera(GLFWwindow *window);
+// follow the camera with the streamed chunks and upload the new ones
+static void streamTerrain();
+static void newTerrain();
+// apply the brushes of the held keys and upload the remeshed bricks
+static void sculptMap(GLFWwindow *window);
+
+// buffers functions
+static void uploadMesh(const Mesh& mesh, MeshBuffers& buffers);
+static void drawMesh(const MeshBuffers& buffers);
+static void deleteBuffers(MeshBuffers& buffers);
 
 // GLFW event callbacks
 static void onKeyPressed(GLFWwindow *window, int key, int scancode, int action, int mods);
@@ -144,13 +220,42 @@ int main(int argc, char *argv[])
 
     // initialize random seed
     srand(time(0));
-    // use simplex noise
-    noise.SetNoiseType(FastNoise::Simplex);
-    // create grid of cells (3D scalar field)
-    cellGrid = CellGrid(GRID_WIDTH, GRID_HEIGHT, GRID_DEPTH);
-
-    generateMap();
-    generateBuffers();
+    TRACE_THREAD_NAME("main");
+    // the generator owns the worker threads shared by the generation steps
+    generator = new MapGenerator(THREAD_COUNT);
+    generator->gridWidth = GRID_WIDTH;
+    generator->gridHeight = GRID_HEIGHT;
+    generator->gridDepth = GRID_DEPTH;
+    generator->octaves = OCTAVES;
+    generator->lacunarity = LACUNARITY;
+    generator->persistance = PERSISTANCE;
+    generator->noiseScale = NOISE_SCALE;
+    generator->surfaceLevel = SURFACE_LEVEL;
+    generator->cubeSize = CUBE_SIZE;
+    generator->minRegionSize = MIN_REGION_SIZE;
+    generator->normalMode = NORMAL_MODE;
+    generator->optimizeMesh = OPTIMIZE_MESH;
+
+    const Mesh& mesh = generator->mesh;
+
+    if(STREAM_TERRAIN){
+        streamer = new ChunkManager(THREAD_COUNT);
+        streamer->settings.chunkSize = CHUNK_SIZE;
+        streamer->settings.octaves = OCTAVES;
+        streamer->settings.lacunarity = LACUNARITY;
+        streamer->settings.persistance = PERSISTANCE;
+        streamer->settings.noiseScale = NOISE_SCALE;
+        streamer->settings.surfaceLevel = SURFACE_LEVEL;
+        streamer->settings.cubeSize = CUBE_SIZE;
+        streamer->settings.optimizeMesh = OPTIMIZE_MESH;
+        streamer->viewDistance = VIEW_DISTANCE;
+        streamer->maxResidentChunks = MAX_RESIDENT_CHUNKS;
+
+        newTerrain();
+    } else {
+        generateMap();
+        generateBuffers();
+    }
 
     int winWidth, winHeight;
     float sx, sy, sz;
@@ -166,15 +271,20 @@ int main(int argc, char *argv[])
     az = -sz * 1.1f;
 
     // camera setup : place it at some distance from the center based on mesh size
-    cam = Camera(vec3d(0, 0, -mesh.dimZ * 2.f), CAM_ROTATION_SPEED, CAM_ZOOM_SPEED);
+    if(STREAM_TERRAIN)
+        cam = Camera(vec3d(0, 0, -CHUNK_SIZE * CUBE_SIZE * 2.f), CAM_ROTATION_SPEED, CAM_ZOOM_SPEED);
+    else
+        cam = Camera(vec3d(0, 0, -mesh.dimZ * 2.f), CAM_ROTATION_SPEED, CAM_ZOOM_SPEED);
 
-    drawWireBox = true;
+    drawWireBox = !STREAM_TERRAIN;
     drawAxes = false;
 
     while(!glfwWindowShouldClose(window))
     {
         // rendering loop
 
+        TRACE_ZONE("frame");
+
         // start recording the frame rendering time
         auto frameStartTime = chrono::high_resolution_clock::now();
 
@@ -194,27 +304,41 @@ int main(int argc, char *argv[])
         glLoadIdentity();
 
         // recalculate camera coordinates
+        moveCamera(window);
         cam.update();
 
         gluLookAt(cam.pos.x, cam.pos.y, cam.pos.z,
-                  0.f, 0.f, 0.f,
+                  cam.center.x, cam.center.y, cam.center.z,
                   0.f, 1.f, 0.f);
 
+        if(STREAM_TERRAIN)
+            streamTerrain();
+        else
+            sculptMap(window);
+
         // draw the mesh from the buffers
 
         glEnable(GL_COLOR_MATERIAL);
         glEnable(GL_LIGHTING);
         glColor3f(1.f, 1.f, 1.f);
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
         glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, 0, (void*)(0));
-
         glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, (void*)(normalsOffset));
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glDrawElements(GL_TRIANGLES, iboCount, GL_UNSIGNED_INT, (void*)(0));
+        if(STREAM_TERRAIN){
+            for(auto it = terrain.begin(); it != terrain.end(); ++it){
+                drawMesh(it->second);
+            }
+        } else if(sculpting){
+            // the unused indices of the bricks are degenerate triangles
+            glBindBuffer(GL_ARRAY_BUFFER, sculpted.vbo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sculpted.ibo);
+            glVertexPointer(3, GL_FLOAT, editor->format.stride(), (void*)0);
+            glNormalPointer(GL_FLOAT, editor->format.stride(), (void*)editor->format.normalOffset());
+            glDrawElements(GL_TRIANGLES, sculptedIndices, GL_UNSIGNED_INT, (void*)0);
+        } else {
+            drawMesh(box);
+        }
 
         glDisableClientState(GL_VERTEX_ARRAY);
         glDisableClientState(GL_NORMAL_ARRAY);
@@ -222,6 +346,16 @@ int main(int argc, char *argv[])
         glDisable(GL_COLOR_MATERIAL);
         glDisable(GL_LIGHTING);
 
+        // draw the brush position
+
+        if(!STREAM_TERRAIN){
+            glPointSize(5.f);
+            glColor3f(1.f, 0.f, 0.f);
+            glBegin(GL_POINTS);
+                glVertex3f(cam.center.x, cam.center.y, cam.center.z);
+            glEnd();
+        }
+
         // draw wire box
 
         glPointSize(1.f);
@@ -270,7 +404,10 @@ int main(int argc, char *argv[])
             glEnd();
         }
 
-        glfwSwapBuffers(window);
+        {
+            TRACE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
 
         glfwPollEvents();
 
@@ -282,11 +419,21 @@ int main(int argc, char *argv[])
             frameTime = frameDuration.count() / 1000000.f;
     }
 
-	glDeleteBuffers(1, &vbo);
-	glDeleteBuffers(1, &ibo);
+    deleteBuffers(box);
+    deleteBuffers(sculpted);
+    for(auto it = terrain.begin(); it != terrain.end(); ++it){
+        deleteBuffers(it->second);
+    }
 
 	glfwTerminate();
 
+    delete editor;
+    delete streamer;
+    delete generator;
+
+    if(Trace::enabled() && Trace::writeChromeTrace(TRACE_FILE))
+        cout << "Trace written to " << TRACE_FILE << endl;
+
     return EXIT_SUCCESS;
 }
 
@@ -294,10 +441,13 @@ int main(int argc, char *argv[])
 static void onKeyPressed(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
     if(action == GLFW_PRESS){
-        if(key == GLFW_KEY_SPACE){
+        if(key == GLFW_KEY_SPACE && STREAM_TERRAIN){
+            newTerrain();
+        } else if(key == GLFW_KEY_SPACE){
             // clear buffers before generating a new map
-            glDeleteBuffers(1, &vbo);
-            glDeleteBuffers(1, &ibo);
+            deleteBuffers(box);
+            deleteBuffers(sculpted);
+            sculpting = false;
             generateMap();
             generateBuffers();
 
@@ -335,60 +485,239 @@ static void onScrollRoll(GLFWwindow *window, double xoff, double yoff)
 
 static void generateMap()
 {
-    cout << "Generating new box";
-
-    auto startTime = chrono::high_resolution_clock::now();
-
-    // delete previous mesh data
-    mesh.clear();
-    // configure noise to a random seed
-    noise.SetSeed(rand());
-    // fill the 3D scalar field
-    cellGrid.fillGrid(noise, OCTAVES, LACUNARITY, PERSISTANCE, NOISE_SCALE);
-    // generate the cube grid according to that scalar field
-    cubeGrid.generateGrid(cellGrid, CUBE_SIZE, SURFACE_LEVEL, MIN_REGION_SIZE);
-    cubeGrid.marchCubes(mesh.vertices);
+    TRACE_ZONE("generateMap");
 
-    mesh.generateMesh(cubeGrid, MIN_REGION_SIZE);
+    cout << "Generating new box";
 
-    // free memory of useless data
-    cubeGrid.clear();
+    // generate a new mesh with a random seed
+    generator->generate(rand());
 
-    auto finishTime = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(finishTime - startTime);
+    const Mesh& mesh = generator->mesh;
 
-    cout << ": seed " << noise.GetSeed();
+    cout << ": seed " << generator->noise.GetSeed();
     cout << " - " << mesh.vertices.size() << " vertices, ";
     cout << mesh.triangles.size() << " triangles";
-    cout << " - " << duration.count() << "ms" << endl;
+    cout << " - " << (int)generator->timings.total << "ms" << endl;
+
+    if(OPTIMIZE_MESH){
+        cout << "  vertex cache : ACMR " << generator->cacheBefore.acmr << " -> " << generator->cacheAfter.acmr;
+        cout << ", ATVR " << generator->cacheBefore.atvr << " -> " << generator->cacheAfter.atvr << endl;
+    }
 }
 
 
 static void generateBuffers()
 {
-    // generate the VBO and load the vertices and normals of the mesh inside
+    TRACE_ZONE("generateBuffers");
+
+    uploadMesh(generator->mesh, box);
+}
+
+
+static void moveCamera(GLFWwindow *window)
+{
+    float step = CAM_MOVE_SPEED * frameTime;
+    float forward = 0.f, right = 0.f, up = 0.f;
+
+    if(glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+        forward += step;
+    if(glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+        forward -= step;
+    if(glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+        right += step;
+    if(glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+        right -= step;
+    if(glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS)
+        up += step;
+    if(glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
+        up -= step;
+
+    cam.moveCenter(forward, right, up);
+}
+
+
+static void streamTerrain()
+{
+    TRACE_ZONE("streamTerrain");
+
+    // the chunks are meshed in the background, only their upload is done here
+
+    streamer->update(cam.center);
+
+    vector<Coord> evicted = streamer->takeEvictedChunks();
+    for(auto it = evicted.begin(); it != evicted.end(); ++it){
+        auto buffers = terrain.find(*it);
+        if(buffers != terrain.end()){
+            deleteBuffers(buffers->second);
+            terrain.erase(buffers);
+        }
+    }
+
+    vector<Coord> loaded = streamer->takeLoadedChunks();
+    uploads.insert(uploads.end(), loaded.begin(), loaded.end());
+
+    for(int n = 0; n < CHUNK_UPLOADS && !uploads.empty(); n++){
+        // the chunk may have been evicted while waiting
+        const ChunkManager::Chunk *chunk = streamer->getChunk(uploads.front());
+        if(chunk != nullptr){
+            MeshBuffers& buffers = terrain[chunk->coord];
+            deleteBuffers(buffers);
+            uploadMesh(chunk->mesh, buffers);
+            buffers.offset = chunk->center;
+        }
+        uploads.pop_front();
+    }
+}
+
+
+static void newTerrain()
+{
+    // drop every chunk and stream the terrain of a new random seed
+
+    for(auto it = terrain.begin(); it != terrain.end(); ++it){
+        deleteBuffers(it->second);
+    }
+    terrain.clear();
+    uploads.clear();
+
+    streamer->noise.SetSeed(rand());
+    streamer->reset();
+    streamer->takeEvictedChunks();
+    streamer->takeLoadedChunks();
+
+    cout << "Streaming new terrain : seed " << streamer->noise.GetSeed() << endl;
+}
+
+
+static void sculptMap(GLFWwindow *window)
+{
+    TRACE_ZONE("sculptMap");
+
+    float strength = BRUSH_STRENGTH * frameTime;
+    vec3d extent(BRUSH_RADIUS, BRUSH_RADIUS, BRUSH_RADIUS);
+
+    bool brushes[5];
+    const int keys[5] = { GLFW_KEY_E, GLFW_KEY_R, GLFW_KEY_N, GLFW_KEY_M, GLFW_KEY_F };
+    bool edited = false;
+
+    for(int n = 0; n < 5; n++){
+        brushes[n] = glfwGetKey(window, keys[n]) == GLFW_PRESS;
+        edited = edited || brushes[n];
+    }
+
+    // the first edit starts sculpting the field of the generated map, its
+    // small regions aren't filtered anymore as that needs the whole field
+    if(edited && !sculpting){
+        if(editor == nullptr)
+            editor = new FieldEditor(VertexFormat::NormalFloat32, THREAD_COUNT);
+        editor->build(generator->getCellGrid(), CUBE_SIZE, SURFACE_LEVEL);
+        sculpting = true;
+    }
+
+    if(!sculpting)
+        return;
+
+    if(brushes[0])
+        editor->addSphere(cam.center, BRUSH_RADIUS, strength);
+    if(brushes[1])
+        editor->subtractSphere(cam.center, BRUSH_RADIUS, strength);
+    if(brushes[2])
+        editor->addBox(cam.center - extent, cam.center + extent, strength);
+    if(brushes[3])
+        editor->subtractBox(cam.center - extent, cam.center + extent, strength);
+    if(brushes[4])
+        editor->smooth(cam.center, BRUSH_RADIUS, min(strength, 1.f));
+
+    if(editor->update() == 0)
+        return;
+
+    // reallocate the buffers when they grew, else only copy the patched slots
+
+    size_t stride = editor->format.stride();
+
+    if(editor->buffersResized || sculpted.vbo == 0){
+        deleteBuffers(sculpted);
+
+        glGenBuffers(1, &sculpted.vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, sculpted.vbo);
+        glBufferData(GL_ARRAY_BUFFER, editor->vertexData.size(), editor->vertexData.data(), GL_DYNAMIC_DRAW);
+
+        glGenBuffers(1, &sculpted.ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sculpted.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, editor->indices.size() * sizeof(uint32_t), editor->indices.data(), GL_DYNAMIC_DRAW);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, sculpted.vbo);
+        for(auto it = editor->changedVertices.begin(); it != editor->changedVertices.end(); ++it){
+            glBufferSubData(GL_ARRAY_BUFFER, it->first * stride, it->count * stride, &editor->vertexData[it->first * stride]);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sculpted.ibo);
+        for(auto it = editor->changedIndices.begin(); it != editor->changedIndices.end(); ++it){
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, it->first * sizeof(uint32_t), it->count * sizeof(uint32_t), &editor->indices[it->first]);
+        }
+    }
+
+    sculptedIndices = editor->indices.size();
+    editor->clearChanges();
+}
+
+
+static void uploadMesh(const Mesh& mesh, MeshBuffers& buffers)
+{
+    // split the mesh into chunks indexed with 16 bit indices
 
-    float *vertices = mesh.getVertexArray();
+    vector<unsigned int> chunkVertices;
+    vector<uint16_t> indices;
 
-    normalsOffset = mesh.vertices.size() * 3 * sizeof(float);
-    vboSize = normalsOffset * 2;
+    mesh.splitChunks(CHUNK_VERTICES, CHUNK_TRIANGLES, buffers.chunks, chunkVertices, indices);
 
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vboSize, &(vertices[0]), GL_STATIC_DRAW);
+    // generate the VBO and pack the interleaved vertices of the chunks directly into it
 
-    delete[] vertices;
+    glGenBuffers(1, &buffers.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vbo);
+    glBufferData(GL_ARRAY_BUFFER, chunkVertices.size() * vertexFormat.stride(), NULL, GL_STATIC_DRAW);
 
-    // generate the IBO and load the triangle indices inside
+    void *vertices = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+    if(vertices != NULL){
+        mesh.packVertices(vertexFormat, vertices, chunkVertices);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
 
-    unsigned int *triangles = mesh.getTriangleArray();
+    // generate the IBO and load the chunk indices inside
 
-    iboCount = mesh.triangles.size() * 3;
-    iboSize = iboCount * sizeof(unsigned int);
+    glGenBuffers(1, &buffers.ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+}
+
+
+static void drawMesh(const MeshBuffers& buffers)
+{
+    glPushMatrix();
+    glTranslatef(buffers.offset.x, buffers.offset.y, buffers.offset.z);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.ibo);
 
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, iboSize, &(triangles[0]), GL_STATIC_DRAW);
+    // the 16 bit indices of a chunk are relative to its first vertex
+    for(auto it = buffers.chunks.begin(); it != buffers.chunks.end(); ++it){
+        size_t vertexOffset = it->firstVertex * vertexFormat.stride();
 
-    delete[] triangles;
+        glVertexPointer(3, GL_FLOAT, vertexFormat.stride(), (void*)(vertexOffset));
+        glNormalPointer(GL_FLOAT, vertexFormat.stride(), (void*)(vertexOffset + vertexFormat.normalOffset()));
+        glDrawElements(GL_TRIANGLES, it->indexCount, GL_UNSIGNED_SHORT, (void*)(it->firstIndex * sizeof(uint16_t)));
+    }
+
+    glPopMatrix();
+}
+
+
+static void deleteBuffers(MeshBuffers& buffers)
+{
+    // deleting the buffer 0 is ignored
+    glDeleteBuffers(1, &buffers.vbo);
+    glDeleteBuffers(1, &buffers.ibo);
+    buffers.vbo = 0;
+    buffers.ibo = 0;
+    buffers.chunks.clear();
 }
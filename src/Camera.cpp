@@ -11,7 +11,7 @@ Camera::Camera()
 
 }
 
-Camera::Camera(vec3d _pos, float _rotSpeed, float _zoomSpeed) : pos(_pos), rotSpeed(_rotSpeed), zoomSpeed(_zoomSpeed)
+Camera::Camera(vec3d _pos, float _rotSpeed, float _zoomSpeed) : pos(_pos), center(), rotSpeed(_rotSpeed), zoomSpeed(_zoomSpeed)
 {
     // setup the camera and calculate start angles and distance
 
@@ -70,6 +70,19 @@ void Camera::update()
     pos.x = distanceFromCenter * cos(heightAngle) * sin(deviationAngle);
     pos.y = distanceFromCenter * sin(heightAngle);
     pos.z = -distanceFromCenter * cos(heightAngle) * cos(deviationAngle);
+
+    pos += center;
+}
+
+void Camera::moveCenter(float forward, float right, float up)
+{
+    // the camera looks from pos towards the center, i.e. along the opposite
+    // of the horizontal part of pos - center
+
+    vec3d front(-sin(deviationAngle), 0.f, cos(deviationAngle));
+    vec3d side(-cos(deviationAngle), 0.f, -sin(deviationAngle));
+
+    center += forward * front + right * side + vec3d(0.f, up, 0.f);
 }
 
 void Camera::enableMovement()
@@ -1,8 +1,15 @@
 #include "CellGrid.h"
 
 #include <FastNoise.h>
+#include <ThreadPool.h>
+#include <algorithm>
+#include <vector>
 #include <vec3d.h>
 #include <math.h>
+#include <new>
+#include <utility>
+#include <string.h>
+#include <Trace.h>
 
 
 using namespace std;
@@ -13,63 +20,173 @@ CellGrid::CellGrid()
 
 }
 
-CellGrid::CellGrid(int _width, int _height, int _depth) : width(_width), height(_height), depth(_depth)
+CellGrid::CellGrid(int _width, int _height, int _depth, MemoryOrder _order) : width(_width), height(_height), depth(_depth), order(_order)
 {
-    cells = new float**[width];
-    for(int i = 0; i < width; i++){
-        cells[i] = new float*[height];
-        for(int j = 0; j < height; j++){
-            cells[i][j] = new float[depth];
-        }
+    allocate();
+}
+
+CellGrid::CellGrid(const CellGrid& other) : width(other.width), height(other.height), depth(other.depth), order(other.order)
+{
+    allocate();
+    if(cellCount > 0)
+        memcpy(cells, other.cells, cellCount * sizeof(float));
+}
+
+CellGrid::CellGrid(CellGrid&& other) : CellGrid()
+{
+    *this = move(other);
+}
+
+CellGrid& CellGrid::operator = (CellGrid other)
+{
+    // copy and swap : the previous buffer is released along with other
+    swap(cells, other.cells);
+    swap(width, other.width);
+    swap(height, other.height);
+    swap(depth, other.depth);
+    swap(order, other.order);
+    swap(cellCount, other.cellCount);
+    swap(bricksY, other.bricksY);
+    swap(bricksZ, other.bricksZ);
+    return *this;
+}
+
+void CellGrid::allocate()
+{
+    if(order == MortonBricks){
+        // partial bricks on the upper borders are padded to full bricks
+        int bricksX = (width + BRICK_SIZE - 1) / BRICK_SIZE;
+        bricksY = (height + BRICK_SIZE - 1) / BRICK_SIZE;
+        bricksZ = (depth + BRICK_SIZE - 1) / BRICK_SIZE;
+        cellCount = (size_t)bricksX * bricksY * bricksZ * BRICK_SIZE*BRICK_SIZE*BRICK_SIZE;
+    } else {
+        cellCount = (size_t)width * height * depth;
     }
+
+    if(cellCount > 0)
+        cells = static_cast<float*>(::operator new[](cellCount * sizeof(float), align_val_t(ALIGNMENT)));
+}
+
+void CellGrid::release()
+{
+    if(cells != nullptr)
+        ::operator delete[](cells, align_val_t(ALIGNMENT));
+    cells = nullptr;
+    cellCount = 0;
 }
 
 void CellGrid::fillGrid(FastNoise& noise, int octaves, float lacunarity, float persistance, float scale)
 {
-    float noiseX, noiseY, noiseZ;
-    float posX, posY, posZ;
+    fillGrid(noise, FillPlan(width, height, depth, octaves, lacunarity, persistance, scale));
+}
+
+void CellGrid::fillGrid(FastNoise& noise, int octaves, float lacunarity, float persistance, float scale, ThreadPool& pool)
+{
+    fillGrid(noise, FillPlan(width, height, depth, octaves, lacunarity, persistance, scale), pool);
+}
+
+void CellGrid::fillGrid(FastNoise& noise, const FillPlan& plan)
+{
+    TRACE_ZONE("CellGrid::fillGrid");
+
+    fillRegion(noise, plan, 0, width, 0, height, 0, depth);
+}
+
+void CellGrid::fillGrid(FastNoise& noise, const FillPlan& plan, ThreadPool& pool)
+{
+    TRACE_ZONE("CellGrid::fillGrid");
+
+    // split the grid in slabs along its slowest varying axis so each slab
+    // covers a contiguous part of the buffer (whole bricks for the Morton order).
+    // Every cell is computed exactly as in the serial fill, the result does not
+    // depend on the number of threads.
+
+    int axisLength = order == ZMajor ? depth : width;
+    int thickness = order == MortonBricks ? BRICK_SIZE : 1;
+    int slabCount = (axisLength + thickness - 1) / thickness;
+
+    pool.parallelFor(slabCount, [&](int slab){
+        TRACE_ZONE("CellGrid::fillGrid slab");
+
+        int start = slab * thickness;
+        int end = min(start + thickness, axisLength);
+
+        if(order == ZMajor)
+            fillRegion(noise, plan, 0, width, 0, height, start, end);
+        else
+            fillRegion(noise, plan, start, end, 0, height, 0, depth);
+    });
+}
+
+void CellGrid::fillRegion(const FastNoise& noise, const FillPlan& plan, int iStart, int iEnd, int jStart, int jEnd, int kStart, int kEnd)
+{
+    // the noise is evaluated one row of cells at a time, along the contiguous
+    // axis of the buffer, with the batch functions of FastNoise
+
+    bool rowAlongX = order == ZMajor;
+
+    int rowStart = rowAlongX ? iStart : kStart;
+    int rowLength = rowAlongX ? iEnd - iStart : kEnd - kStart;
+    int outerStart = rowAlongX ? kStart : iStart;
+    int outerEnd = rowAlongX ? kEnd : iEnd;
+
+    if(rowLength <= 0)
+        return;
+
+    vector<float> rowX(rowLength), rowY(rowLength), rowZ(rowLength);
+    vector<float> rowNoise(rowLength);
+    vector<float> rowValue(rowLength);
+
+    // closed edges weights of the row axis
+    const float *rowWeights = rowAlongX ? &plan.weightX[rowStart] : &plan.weightZ[rowStart];
+
     float noiseValue;
     float weight;
+    float outerWeight;
     float frequency;
+    double amplitude;
 
 
-    for(int i = 0; i < width; i++){
-        for(int j = 0; j < height; j++){
-            for(int k = 0; k < depth; k++){
+    for(int outer = outerStart; outer < outerEnd; outer++){
+        for(int j = jStart; j < jEnd; j++){
 
-                noiseValue = 0.;
+            fill(rowValue.begin(), rowValue.end(), 0.f);
 
-                for(int u = 0; u < octaves; u++){
-                    frequency = pow(lacunarity, u) * scale;
-                    noiseX = (float)i * frequency;
-                    noiseY = (float)j * frequency;
-                    noiseZ = (float)k * frequency;
-                    noiseValue += noise.GetNoise(noiseX, noiseY, noiseZ) * pow(persistance, u);
-                }
+            for(int u = 0; u < plan.octaves; u++){
+                frequency = plan.frequencies[u];
+                amplitude = plan.amplitudes[u];
 
+                for(int n = 0; n < rowLength; n++){
+                    rowX[n] = (float)(plan.originX + (rowAlongX ? rowStart + n : outer)) * frequency;
+                    rowY[n] = (float)(plan.originY + j) * frequency;
+                    rowZ[n] = (float)(plan.originZ + (rowAlongX ? outer : rowStart + n)) * frequency;
+                }
 
-                // TODO : add more parameters to allow configurable patterns such as terracing
-                // commented hardcode example below:
+                noise.GetNoiseSet(rowX.data(), rowY.data(), rowZ.data(), rowNoise.data(), rowLength);
 
-                /*y = (float)j * 0.1f - 0.1f * height/2.f;
-                noiseValue = -(y + 1.f) + noiseValue * 1.9f + fmod(y, 0.9f) * 1.f;*/
+                for(int n = 0; n < rowLength; n++){
+                    rowValue[n] += rowNoise[n] * amplitude;
+                }
+            }
 
-                // ensure closed edges, comment the code bellow and just assign the
-                // noise value to the cell to remove them
+            // TODO : add more parameters to allow configurable patterns such as terracing
+            // commented hardcode example below:
 
-                posX = fabs((float)i - (float)width / 2.f + 0.5f) * 2.f;
-                posY = fabs((float)j - (float)height / 2.f + 0.5f) * 2.f;
-                posZ = fabs((float)k - (float)depth / 2.f + 0.5f) * 2.f;
+            /*y = (float)j * 0.1f - 0.1f * height/2.f;
+            noiseValue = -(y + 1.f) + noiseValue * 1.9f + fmod(y, 0.9f) * 1.f;*/
 
-                posX += -width + 2.f;
-                posY += -height + 2.f;
-                posZ += -depth + 2.f;
+            // ensure closed edges, use a null weight to remove them
 
-                weight = max(posX, max(posY, posZ));
+            outerWeight = max(rowAlongX ? plan.weightZ[outer] : plan.weightX[outer], plan.weightY[j]);
 
-                weight = weight < 0.f ? 0.f : weight > 1.f ? 1.f : weight;
+            for(int n = 0; n < rowLength; n++){
+                noiseValue = rowValue[n];
+                weight = max(outerWeight, rowWeights[n]);
 
-                cells[i][j][k] = noiseValue * (1 - weight) - 100.f * weight;
+                if(rowAlongX)
+                    at(rowStart + n, j, outer) = noiseValue * (1 - weight) - 100.f * weight;
+                else
+                    at(outer, j, rowStart + n) = noiseValue * (1 - weight) - 100.f * weight;
             }
         }
     }
@@ -77,5 +194,5 @@ void CellGrid::fillGrid(FastNoise& noise, int octaves, float lacunarity, float p
 
 CellGrid::~CellGrid()
 {
-
+    release();
 }
@@ -0,0 +1,290 @@
+#include "ChunkManager.h"
+
+#include <FastNoise.h>
+#include <FillPlan.h>
+#include <CellGrid.h>
+#include <CubeGrid.h>
+#include <NodeField.h>
+#include <Mesh.h>
+#include <Coord.h>
+#include <vec3d.h>
+#include <ThreadPool.h>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <math.h>
+#include <Trace.h>
+
+using namespace std;
+
+
+ChunkManager::ChunkManager(int threadCount) : generation(0), pool(threadCount)
+{
+    noise.SetNoiseType(FastNoise::Simplex);
+}
+
+Coord ChunkManager::chunkAt(const vec3d& position) const
+{
+    float chunkWidth = settings.chunkSize * settings.cubeSize;
+
+    return Coord((int)floor(position.x / chunkWidth),
+                 (int)floor(position.y / chunkWidth),
+                 (int)floor(position.z / chunkWidth));
+}
+
+vec3d ChunkManager::chunkCenter(const Coord& coord) const
+{
+    float chunkWidth = settings.chunkSize * settings.cubeSize;
+
+    return vec3d((coord.i + 0.5f) * chunkWidth, (coord.j + 0.5f) * chunkWidth, (coord.k + 0.5f) * chunkWidth);
+}
+
+void ChunkManager::update(const vec3d& position)
+{
+    TRACE_ZONE("ChunkManager::update");
+
+    Coord center = chunkAt(position);
+
+    collectFinished(center);
+    evictChunks(center);
+    scheduleChunks(center);
+}
+
+void ChunkManager::reset()
+{
+    // the jobs in flight are left running but their chunks will be dropped
+    generation++;
+
+    while(!resident.empty())
+        evict(resident.begin());
+
+    pending.clear();
+
+    lock_guard<mutex> guard(finishedLock);
+    finished.clear();
+}
+
+const ChunkManager::Chunk* ChunkManager::getChunk(const Coord& coord) const
+{
+    auto it = resident.find(coord);
+    return it == resident.end() ? nullptr : it->second.get();
+}
+
+vector<Coord> ChunkManager::takeLoadedChunks()
+{
+    vector<Coord> chunks;
+    chunks.swap(loaded);
+    return chunks;
+}
+
+vector<Coord> ChunkManager::takeEvictedChunks()
+{
+    vector<Coord> chunks;
+    chunks.swap(evicted);
+    return chunks;
+}
+
+void ChunkManager::generateChunk(Chunk& chunk, const Settings& settings, FastNoise& noise)
+{
+    TRACE_ZONE("ChunkManager::generateChunk");
+
+    // a chunk of n cubes has n+1 nodes along each side, the last ones being
+    // the first ones of the next chunk. Without closed edges nor region
+    // filtering, both chunks find the same vertices on their shared face.
+    // The noise is sampled one more node around the chunk, so the gradient
+    // on its faces takes the central differences with the neighbour's values
+    // and both chunks also find the same normals.
+
+    int size = settings.chunkSize;
+    int nodes = size + 1;
+    int ghosted = nodes + 2;
+
+    CellGrid ghostGrid(ghosted, ghosted, ghosted);
+    FillPlan plan(ghosted, ghosted, ghosted, settings.octaves, settings.lacunarity, settings.persistance, settings.noiseScale, false);
+    plan.originX = chunk.coord.i * size - 1;
+    plan.originY = chunk.coord.j * size - 1;
+    plan.originZ = chunk.coord.k * size - 1;
+    ghostGrid.fillGrid(noise, plan);
+
+    CellGrid cellGrid(nodes, nodes, nodes);
+    for(int k = 0; k < nodes; k++){
+        for(int j = 0; j < nodes; j++){
+            for(int i = 0; i < nodes; i++){
+                cellGrid.at(i, j, k) = ghostGrid.at(i + 1, j + 1, k + 1);
+            }
+        }
+    }
+
+    CubeGrid cubeGrid;
+    cubeGrid.generateGrid(cellGrid, settings.cubeSize, settings.surfaceLevel, 0);
+
+    // the nodes are centered around the origin, so is the mesh
+    float chunkWidth = size * settings.cubeSize;
+    chunk.center = vec3d((chunk.coord.i + 0.5f) * chunkWidth, (chunk.coord.j + 0.5f) * chunkWidth, (chunk.coord.k + 0.5f) * chunkWidth);
+
+    // the gradient normals are computed once, from the bigger grid
+    bool ghostNormals = settings.normalMode == Mesh::FieldGradient;
+
+    chunk.mesh.clear();
+    chunk.mesh.normalMode = ghostNormals ? Mesh::NoNormals : settings.normalMode;
+    chunk.mesh.generateMesh(cubeGrid, 0, true);
+    chunk.mesh.normalMode = settings.normalMode;
+
+    // both grids are centered on the chunk center
+    if(ghostNormals){
+        NodeField ghostNodes(ghosted, ghosted, ghosted, settings.cubeSize);
+        for(int k = 0; k < ghosted; k++){
+            for(int j = 0; j < ghosted; j++){
+                for(int i = 0; i < ghosted; i++){
+                    ghostNodes.value(i, j, k) = ghostGrid.at(i, j, k);
+                }
+            }
+        }
+        chunk.mesh.calculateGradientNormals(ghostNodes);
+    }
+
+    if(settings.optimizeMesh){
+        chunk.mesh.optimizeVertexCache();
+        chunk.mesh.optimizeVertexFetch();
+    }
+}
+
+long long ChunkManager::distance2(const Coord& c1, const Coord& c2)
+{
+    long long di = c1.i - c2.i, dj = c1.j - c2.j, dk = c1.k - c2.k;
+    return di*di + dj*dj + dk*dk;
+}
+
+void ChunkManager::collectFinished(const Coord& center)
+{
+    vector<Result> results;
+    {
+        lock_guard<mutex> guard(finishedLock);
+        results.swap(finished);
+    }
+
+    long long keep = (long long)(viewDistance + 1) * (viewDistance + 1);
+
+    for(auto it = results.begin(); it != results.end(); ++it){
+        // results of a previous generation aren't pending anymore
+        if(it->generation != generation)
+            continue;
+
+        Coord coord = it->chunk->coord;
+        pending.erase(coord);
+
+        // the position moved away while the chunk was being meshed
+        if(distance2(coord, center) > keep)
+            continue;
+
+        resident[coord] = move(it->chunk);
+        loaded.push_back(coord);
+    }
+}
+
+void ChunkManager::evictChunks(const Coord& center)
+{
+    // chunks are kept one chunk beyond the view distance so moving back and
+    // forth across a chunk border doesn't reload them
+
+    long long keep = (long long)(viewDistance + 1) * (viewDistance + 1);
+
+    for(auto it = resident.begin(); it != resident.end();){
+        auto next = it;
+        ++next;
+        if(distance2(it->first, center) > keep)
+            evict(it);
+        it = next;
+    }
+
+    if(resident.size() <= maxResidentChunks)
+        return;
+
+    // still too many chunks : evict the farthest ones
+    vector<pair<long long, Coord>> byDistance;
+    for(auto it = resident.begin(); it != resident.end(); ++it){
+        byDistance.push_back(make_pair(distance2(it->first, center), it->first));
+    }
+
+    size_t excess = resident.size() - maxResidentChunks;
+    nth_element(byDistance.begin(), byDistance.begin() + excess, byDistance.end(),
+                [](const pair<long long, Coord>& a, const pair<long long, Coord>& b){ return a.first > b.first; });
+
+    for(size_t n = 0; n < excess; n++){
+        evict(resident.find(byDistance[n].second));
+    }
+}
+
+void ChunkManager::scheduleChunks(const Coord& center)
+{
+    // offsets of the chunks in the view sphere sorted by distance, so the
+    // nearest chunks are meshed first
+    if(offsetsDistance != viewDistance){
+        offsets.clear();
+        long long reach = (long long)viewDistance * viewDistance;
+
+        for(int i = -viewDistance; i <= viewDistance; i++){
+            for(int j = -viewDistance; j <= viewDistance; j++){
+                for(int k = -viewDistance; k <= viewDistance; k++){
+                    if(distance2(Coord(i, j, k), Coord()) <= reach)
+                        offsets.push_back(Coord(i, j, k));
+                }
+            }
+        }
+
+        stable_sort(offsets.begin(), offsets.end(), [](const Coord& a, const Coord& b){
+            return distance2(a, Coord()) < distance2(b, Coord());
+        });
+
+        offsetsDistance = viewDistance;
+    }
+
+    size_t maxPending = maxPendingChunks > 0 ? maxPendingChunks : 2 * (size_t)getThreadCount();
+    unsigned int jobGeneration = generation;
+
+    for(auto it = offsets.begin(); it != offsets.end(); ++it){
+        if(pending.size() >= maxPending || resident.size() + pending.size() >= maxResidentChunks)
+            break;
+
+        Coord coord(center.i + it->i, center.j + it->j, center.k + it->k);
+        if(resident.count(coord) > 0 || pending.count(coord) > 0)
+            continue;
+
+        pending.insert(coord);
+
+        // the job works on its own copy of the settings and of the noise
+        Settings jobSettings = settings;
+        FastNoise jobNoise = noise;
+
+        pool.submit([this, coord, jobSettings, jobNoise, jobGeneration]() mutable {
+            if(generation != jobGeneration)
+                return;
+
+            unique_ptr<Chunk> chunk(new Chunk());
+            chunk->coord = coord;
+            generateChunk(*chunk, jobSettings, jobNoise);
+
+            Result result;
+            result.generation = jobGeneration;
+            result.chunk = move(chunk);
+
+            lock_guard<mutex> guard(finishedLock);
+            finished.push_back(move(result));
+        });
+    }
+}
+
+void ChunkManager::evict(map<Coord, unique_ptr<Chunk>>::iterator it)
+{
+    evicted.push_back(it->first);
+    resident.erase(it);
+}
+
+ChunkManager::~ChunkManager()
+{
+    // the pool runs the queued jobs before stopping, make them return at once
+    generation++;
+}
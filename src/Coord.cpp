@@ -1,6 +1,6 @@
 #include "Coord.h"
 
-Coord::Coord()
+Coord::Coord() : i(0), j(0), k(0)
 {
 
 }
@@ -9,3 +9,22 @@ Coord::Coord(int _i, int _j, int _k) : i(_i), j(_j), k(_k)
 {
 
 }
+
+bool operator == (const Coord& c1, const Coord& c2)
+{
+    return c1.i == c2.i && c1.j == c2.j && c1.k == c2.k;
+}
+
+bool operator != (const Coord& c1, const Coord& c2)
+{
+    return !(c1 == c2);
+}
+
+bool operator < (const Coord& c1, const Coord& c2)
+{
+    if(c1.i != c2.i)
+        return c1.i < c2.i;
+    if(c1.j != c2.j)
+        return c1.j < c2.j;
+    return c1.k < c2.k;
+}
@@ -1,11 +1,13 @@
 #include "Cube.h"
 
 #include <vec3d.h>
-#include <ControlNode.h>
+#include <NodeField.h>
+#include <EdgeCache.h>
 #include <vector>
-#include <set>
+#include <cstdint>
 #include <Table.h>
 #include <Vertex.h>
+#include <Triangle.h>
 
 using namespace std;
 
@@ -15,98 +17,113 @@ Cube::Cube()
 
 }
 
-Cube::Cube(ControlNode **_controlNodes, int _bordering) : controlNodes(_controlNodes), bordering(_bordering)
+// offsets of the 8 nodes of a cube from its first node :
+// front face first, then the back face directly opposite to it
+static const int nodeOffsets[8][3] = {
+    {0, 0, 0}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0},
+    {0, 0, 1}, {0, 1, 1}, {1, 1, 1}, {1, 0, 1}
+};
+
+// node each edge starts from along its axis, and that axis (0 : x, 1 : y, 2 : z)
+static const int edgeOrigin[12] = { 0, 1, 3, 0, 4, 5, 7, 4, 0, 1, 2, 3 };
+static const int edgeAxis[12] = { 1, 0, 1, 0, 1, 0, 1, 0, 2, 2, 2, 2 };
+
+Cube::Cube(const NodeField& _nodes, int _i, int _j, int _k) : nodes(&_nodes), i(_i), j(_j), k(_k)
 {
     // calculate the configuration of the current cube
     configuration = 0;
-    for(int i = 0; i < 8; i++){
-        if(controlNodes[i]->active){
-            configuration |= 1 << i;
+    for(int n = 0; n < 8; n++){
+        if(nodes->isActive(i + nodeOffsets[n][0], j + nodeOffsets[n][1], k + nodeOffsets[n][2])){
+            configuration |= 1 << n;
         }
     }
-
-    edgeNodes = new int[12];
-    /*for(int i = 0; i < 12; i++){
-        edgeNodes[i] = -1;
-    }*/
 }
 
-void Cube::createVertices(vector<Vertex>& vertices, float surfaceLevel)
+void Cube::createVertices(vector<Vertex>& vertices, EdgeCache& edgeCache, float surfaceLevel)
 {
-    // which vertex to draw in addition to the 3 necessary ones
-    // according to the position of the cube, i.e. vertices
-    // that can't be determined by surrounding cubes
-    static const int bordTable[8][9] = {
-        {-1, -1,  -1, -1, -1, -1, -1, -1, -1 },    // 0
-        {2, 11, -1, -1, -1, -1, -1, -1, -1 },      // 1
-        {9, 1,  -1, -1, -1, -1, -1, -1, -1 },      // 2
-        {2, 11, 9, 1, 10, -1, -1, -1, -1 },        // 3
-        {4, 7,  -1, -1, -1,  -1, -1, -1, -1 },     // 4
-        {2, 11, 4, 7, 6, -1, -1, -1, -1 },         // 5
-        {4, 7,  1, 9, 5, -1, -1, -1, -1 },         // 6
-        {2, 11, 4, 7, 6,  5, 10, 9, 1}             // 7
-    };
-
-    set<int> additionalEdges;
-
-    for(int i = 0; i < 9 && bordTable[bordering][i] != -1; i++){
-        additionalEdges.insert(bordTable[bordering][i]);
-    }
+    // only the edges that exist according to the triangulation table
+    unsigned int edges = edgeTable[configuration];
 
-    const int *triConfig = triTable[configuration];
-    set<int> edges; // store all edges that have to be calculated
-    int edge; // store a local edge index
+    int origin;
 
-    // only add edges that exist according to the triangulation table
-    // and that are necessary
+    // get or calculate the vertices
 
-    for(int i = 0; triConfig[i] != -1; i++){
-        edge = triConfig[i];
-        if(edge == 0 || edge == 3 || edge == 8 || additionalEdges.find(edge) != additionalEdges.end())
-            edges.insert(edge);
-    }
+    for(int edge = 0; edges != 0; edge++, edges >>= 1){
+        if((edges & 1) == 0)
+            continue;
 
-    int a, b; // edge extremities
-    int vertexIndex; // store the global index of an edge/vertex
+        origin = edgeOrigin[edge];
 
-    // calculate the vertices
+        int ei = i + nodeOffsets[origin][0];
+        int ej = j + nodeOffsets[origin][1];
+        int ek = k + nodeOffsets[origin][2];
 
-    for(auto it = edges.begin(); it != edges.end(); ++it){
-        edge = *it;
+        int& vertexIndex = edgeCache.vertex(ei, ej, ek, edgeAxis[edge]);
 
-        // determine the correct extremities
+        if(vertexIndex == EdgeCache::NO_VERTEX){
+            vertexIndex = vertices.size();
+            vertices.push_back(Vertex(nodes->edgeVertex(ei, ej, ek, edgeAxis[edge], surfaceLevel)));
+        }
 
-        a = edge;
+        edgeNodes[edge] = vertexIndex;
+    }
+}
 
-        if(edge <= 3){
-            b = a == 3 ? 0 : a + 1;
-        } else if(edge <= 7){
-            b = a == 7 ? 4 : a + 1;
-        } else {
-            a -= 8;
-            b = a + 4;
-        }
+void Cube::readVertices(EdgeCache& edgeCache)
+{
+    unsigned int edges = edgeTable[configuration];
+    int origin;
 
-        vertexIndex = vertices.size();
+    for(int edge = 0; edges != 0; edge++, edges >>= 1){
+        if((edges & 1) == 0)
+            continue;
 
-        edgeNodes[edge] = vertexIndex;
+        origin = edgeOrigin[edge];
+        edgeNodes[edge] = edgeCache.vertex(i + nodeOffsets[origin][0], j + nodeOffsets[origin][1], k + nodeOffsets[origin][2], edgeAxis[edge]);
+    }
+}
+
+void Cube::createTriangles(vector<Triangle>& triangles) const
+{
+    const int8_t *triConfig = &triangleList[triangleOffsets[configuration]];
+
+    int a, b, c;
+
+    for(int n = 0; n < triangleCounts[configuration] * 3; n += 3){
+        a = edgeNodes[triConfig[n]];
+        b = edgeNodes[triConfig[n+1]];
+        c = edgeNodes[triConfig[n+2]];
+        triangles.push_back(Triangle(a, b, c));
+    }
+}
+
+Triangle* Cube::createTriangles(Triangle *triangles) const
+{
+    const int8_t *triConfig = &triangleList[triangleOffsets[configuration]];
 
-        vertices.push_back(Vertex(interpolate(a, b, surfaceLevel)));
+    for(int n = 0; n < triangleCounts[configuration] * 3; n += 3){
+        *triangles++ = Triangle(edgeNodes[triConfig[n]], edgeNodes[triConfig[n+1]], edgeNodes[triConfig[n+2]]);
     }
+
+    return triangles;
 }
 
-vec3d Cube::interpolate(int a, int b, float t)
+void Cube::accumulateNormals(vector<Vertex>& vertices) const
 {
-    // returns the vertex at the corresponding edge
-    // with interpolated coordinates
+    const int8_t *triConfig = &triangleList[triangleOffsets[configuration]];
 
-    vec3d& p1 = controlNodes[a]->pos;
-    vec3d& p2 = controlNodes[b]->pos;
+    for(int n = 0; n < triangleCounts[configuration] * 3; n += 3){
+        Vertex& v1 = vertices[edgeNodes[triConfig[n]]];
+        Vertex& v2 = vertices[edgeNodes[triConfig[n+1]]];
+        Vertex& v3 = vertices[edgeNodes[triConfig[n+2]]];
 
-    float v1 = controlNodes[a]->value;
-    float v2 = controlNodes[b]->value;
+        // the length of the cross product is twice the area of the triangle
+        vec3d normal = vec3d::cross(v2.pos - v1.pos, v3.pos - v1.pos);
 
-    return p1 + (t - v1) * (p2 - p1) / (v2 - v1);
+        v1.normal += normal;
+        v2.normal += normal;
+        v3.normal += normal;
+    }
 }
 
 Cube::~Cube()
@@ -3,11 +3,25 @@
 #include <vec3d.h>
 #include <Cube.h>
 #include <CellGrid.h>
-#include <Coord.h>
 #include <vector>
-#include <queue>
+#include <cstdint>
 #include <Vertex.h>
-
+#include <Triangle.h>
+#include <EdgeCache.h>
+#include <Table.h>
+#include <ThreadPool.h>
+#include <algorithm>
+#include <UnionFind.h>
+#include <chrono>
+#include <Trace.h>
+
+using namespace std;
+
+// milliseconds elapsed since start
+static double elapsed(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
 
 CubeGrid::CubeGrid()
 {
@@ -16,8 +30,38 @@ CubeGrid::CubeGrid()
 
 void CubeGrid::generateGrid(CellGrid& cellGrid, float _cubeSize, float _surfaceLevel, unsigned int minRegionSize)
 {
-    // Calculate the coordinates of each cube vertex (i.e. control nodes)
-    // First calculate the coordinates of each cells
+    TRACE_ZONE("CubeGrid::generateGrid");
+
+    auto startTime = chrono::high_resolution_clock::now();
+    createNodes(cellGrid, _cubeSize, _surfaceLevel);
+    timings.createNodes = elapsed(startTime);
+
+    startTime = chrono::high_resolution_clock::now();
+    if(minRegionSize > 0)
+        ignoreSmallRegions(minRegionSize, nullptr);
+    timings.ignoreSmallRegions = elapsed(startTime);
+}
+
+void CubeGrid::generateGrid(CellGrid& cellGrid, float _cubeSize, float _surfaceLevel, unsigned int minRegionSize, ThreadPool& pool)
+{
+    TRACE_ZONE("CubeGrid::generateGrid");
+
+    auto startTime = chrono::high_resolution_clock::now();
+    createNodes(cellGrid, _cubeSize, _surfaceLevel);
+    timings.createNodes = elapsed(startTime);
+
+    startTime = chrono::high_resolution_clock::now();
+    if(minRegionSize > 0)
+        ignoreSmallRegions(minRegionSize, &pool);
+    timings.ignoreSmallRegions = elapsed(startTime);
+}
+
+void CubeGrid::createNodes(CellGrid& cellGrid, float _cubeSize, float _surfaceLevel)
+{
+    TRACE_ZONE("CubeGrid::createNodes");
+
+    // Store the value and state of each cube vertex (i.e. control nodes),
+    // their positions are calculated on demand from their coordinates
 
     width = cellGrid.width - 1;
     height = cellGrid.height - 1;
@@ -26,231 +70,388 @@ void CubeGrid::generateGrid(CellGrid& cellGrid, float _cubeSize, float _surfaceL
     cubeSize = _cubeSize;
     surfaceLevel = _surfaceLevel;
 
-    controlNodes = new ControlNode**[cellGrid.width];
-    for(int i = 0; i < cellGrid.width; i++){
-        controlNodes[i] = new ControlNode*[cellGrid.height];
-        for(int j = 0; j < cellGrid.height; j++){
-            controlNodes[i][j] = new ControlNode[cellGrid.depth];
-            for(int k = 0; k < cellGrid.depth; k++){
+    nodes = NodeField(cellGrid.width, cellGrid.height, cellGrid.depth, cubeSize);
+
+    // nodes are written in storage order, one activity word at a time
+    size_t n = 0;
+    uint64_t activeWord = 0;
+
+    for(int k = 0; k < nodes.depth; k++){
+        for(int j = 0; j < nodes.height; j++){
+            for(int i = 0; i < nodes.width; i++){
+                float value = cellGrid.at(i, j, k);
 
-                vec3d pos(-cellGrid.width*cubeSize/2.f + i*cubeSize + cubeSize/2.f,
-                          -cellGrid.height*cubeSize/2.f + j*cubeSize + cubeSize/2.f,
-                          -cellGrid.depth*cubeSize/2.f + k*cubeSize + cubeSize/2.f);
+                nodes.values[n] = value;
+                if(value > surfaceLevel)
+                    activeWord |= (uint64_t)1 << (n & 63);
 
-                controlNodes[i][j][k] = ControlNode(pos, cellGrid.cells[i][j][k], cellGrid.cells[i][j][k] > surfaceLevel);
+                n++;
+                if((n & 63) == 0){
+                    nodes.activeBits[(n >> 6) - 1] = activeWord;
+                    activeWord = 0;
+                }
             }
         }
     }
-
-    if(minRegionSize > 0)
-        ignoreSmallRegions(cellGrid, minRegionSize);
+    if((n & 63) != 0)
+        nodes.activeBits[n >> 6] = activeWord;
 }
 
-void CubeGrid::ignoreSmallRegions(CellGrid& cellGrid, unsigned int minNodeCount)
+void CubeGrid::ignoreSmallRegions(unsigned int minNodeCount, ThreadPool *pool)
 {
     // Removes small regions of control nodes to avoid useless small terrain features
     // Since some small region can still be connected to bigger ones, a similar
     // process on the calculated edge vertices will be necessary.
     // This step though helps to reduce the final number of vertices
 
-    // floodfill algorithm : keep in memory visited vertices during process
-    bool ***visited = new bool**[cellGrid.width];
-    for(int i = 0; i < cellGrid.width; i++){
-        visited[i] = new bool*[cellGrid.height];
-        for(int j = 0; j < cellGrid.height; j++){
-            visited[i][j] = new bool[cellGrid.depth];
-            for(int k = 0; k < cellGrid.depth; k++){
-                visited[i][j][k] = false;
+    // Regions are labeled by runs of consecutive active nodes along x : the
+    // runs of each row are read from the bitset, then the runs of neighbouring
+    // rows that touch are merged in a union-find structure.
+    // Two nodes are connected when they differ by one along one or two axes
+    // (the 18 neighbours of a node sharing a face or an edge with it).
+    // With a pool, the node slices are split in blocks labeled concurrently,
+    // the blocks being merged along their borders afterwards.
+
+    TRACE_ZONE("CubeGrid::ignoreSmallRegions");
+
+    int rowCount = nodes.height * nodes.depth;
+    int blockCount = pool != nullptr ? min(nodes.depth, pool->getThreadCount() * 4) : 1;
+    if(blockCount <= 0)
+        return;
+
+    auto blockStart = [&](int block){ return (int)((long long)nodes.depth * block / blockCount); };
+
+    // runs of each row, rows in storage order (row = k * height + j)
+
+    vector<vector<NodeRun>> blockRuns(blockCount);
+    vector<unsigned int> rowFirstRun(rowCount + 1, 0);
+
+    auto findBlockRuns = [&](int block){
+        TRACE_ZONE("CubeGrid::ignoreSmallRegions runs");
+        for(int k = blockStart(block); k < blockStart(block + 1); k++){
+            for(int j = 0; j < nodes.height; j++){
+                size_t before = blockRuns[block].size();
+                findRowRuns(j, k, blockRuns[block]);
+                rowFirstRun[k * nodes.height + j + 1] = blockRuns[block].size() - before;
             }
         }
+    };
+
+    if(pool != nullptr)
+        pool->parallelFor(blockCount, findBlockRuns);
+    else
+        findBlockRuns(0);
+
+    for(int row = 0; row < rowCount; row++){
+        rowFirstRun[row + 1] += rowFirstRun[row];
     }
 
-    vector<Coord> regionNodes; // stores the nodes of a particular region
+    vector<NodeRun> runs;
+    runs.reserve(rowFirstRun[rowCount]);
+    for(auto it = blockRuns.begin(); it != blockRuns.end(); ++it){
+        runs.insert(runs.end(), it->begin(), it->end());
+        vector<NodeRun>().swap(*it);
+    }
 
-    for(int i = 0; i < cellGrid.width; i++){
-        for(int j = 0; j < cellGrid.height; j++){
-            for(int k = 0; k < cellGrid.depth; k++){
-                if(controlNodes[i][j][k].active && !visited[i][j][k]){
-                    Coord startCoord(i, j, k);
-                    detectRegionNodes(cellGrid, startCoord, visited, regionNodes);
+    // merge the runs of each row with the ones of the rows before it
 
-                    if(regionNodes.size() < minNodeCount){
-                        for(auto it = regionNodes.begin(); it != regionNodes.end(); ++it){
-                            Coord& c = *it;
-                            controlNodes[c.i][c.j][c.k].active = false;
-                        }
-                    }
+    UnionFind regions(runs.size());
 
-                    regionNodes.clear();
-                }
+    auto connectSlice = [&](int k){
+        for(int j = 0; j < nodes.height; j++){
+            int row = k * nodes.height + j;
+
+            if(j > 0)
+                connectRows(regions, runs, rowFirstRun, row, row - 1, 1);
+            if(k > 0){
+                int below = row - nodes.height;
+                connectRows(regions, runs, rowFirstRun, row, below, 1);
+                if(j > 0)
+                    connectRows(regions, runs, rowFirstRun, row, below - 1, 0);
+                if(j < nodes.height - 1)
+                    connectRows(regions, runs, rowFirstRun, row, below + 1, 0);
             }
         }
+    };
+
+    // the runs of a block only get merged with runs of the same block,
+    // so the blocks don't share any element of the union-find structure
+    auto connectBlock = [&](int block){
+        TRACE_ZONE("CubeGrid::ignoreSmallRegions connect");
+        for(int k = blockStart(block); k < blockStart(block + 1); k++){
+            if(k > 0 && k == blockStart(block))
+                continue;
+            connectSlice(k);
+        }
+    };
+
+    if(pool != nullptr)
+        pool->parallelFor(blockCount, connectBlock);
+    else
+        connectBlock(0);
+
+    for(int block = 1; block < blockCount; block++){
+        connectSlice(blockStart(block));
+    }
+
+    // count the nodes of each region at its root, then clear the small ones
+
+    vector<unsigned int> regionNodes(runs.size(), 0);
+
+    for(unsigned int r = 0; r < runs.size(); r++){
+        regionNodes[regions.find(r)] += runs[r].end - runs[r].start;
     }
 
-    for(int i = 0; i < cellGrid.width; i++){
-        for(int j = 0; j < cellGrid.height; j++){
-            delete[] visited[i][j];
+    for(int row = 0; row < rowCount; row++){
+        size_t rowStart = (size_t)row * nodes.width;
+
+        for(unsigned int r = rowFirstRun[row]; r < rowFirstRun[row + 1]; r++){
+            if(regionNodes[regions.find(r)] < minNodeCount)
+                nodes.setActive(rowStart + runs[r].start, rowStart + runs[r].end, false);
         }
-        delete[] visited[i];
     }
-    delete[] visited;
 }
 
-void CubeGrid::detectRegionNodes(CellGrid& cellGrid, Coord startCoord, bool ***visited, vector<Coord>& regionNodes)
+void CubeGrid::findRowRuns(int j, int k, vector<NodeRun>& runs) const
 {
-    // Floodfill implementation to detect groups of active nodes
+    size_t rowStart = nodes.index(0, j, k);
+    size_t rowEnd = rowStart + nodes.width;
+    size_t n = rowStart;
 
-    queue<Coord> q;
+    while(n < rowEnd){
+        size_t start = nodes.nextActive(n, rowEnd);
+        if(start == rowEnd)
+            break;
 
-    visited[startCoord.i][startCoord.j][startCoord.k] = true;
+        n = nodes.nextInactive(start, rowEnd);
 
-    regionNodes.push_back(startCoord);
-    q.push(regionNodes.back());
+        NodeRun run;
+        run.start = (int)(start - rowStart);
+        run.end = (int)(n - rowStart);
+        runs.push_back(run);
+    }
+}
 
-    Coord c;
+void CubeGrid::connectRows(UnionFind& regions, const vector<NodeRun>& runs, const vector<unsigned int>& rowFirstRun,
+                           int row, int other, int reach)
+{
+    unsigned int a = rowFirstRun[row];
+    unsigned int b = rowFirstRun[other];
+    unsigned int aEnd = rowFirstRun[row + 1];
+    unsigned int bEnd = rowFirstRun[other + 1];
+
+    // both rows are sorted along x, advance the run ending first
+    while(a < aEnd && b < bEnd){
+        const NodeRun& runA = runs[a];
+        const NodeRun& runB = runs[b];
+
+        if(runA.start < runB.end + reach && runB.start < runA.end + reach)
+            regions.unite(a, b);
+
+        if(runA.end < runB.end)
+            a++;
+        else
+            b++;
+    }
+}
 
-    while(!q.empty()){
-        c = q.front();
-        q.pop();
+void CubeGrid::marchCubes(vector<Vertex>& vertices, vector<Triangle>& triangles, bool accumulateNormals)
+{
+    // go through the cubes one z slice at a time, each crossing edge is
+    // interpolated by the first cube reaching it and its vertex index is
+    // kept in the cache for the other cubes sharing it
 
-        for(int i = c.i - 1; i <= c.i + 1; i++){
-            for(int j = c.j - 1; j <= c.j + 1; j++){
-                for(int k = c.k - 1; k <= c.k + 1; k++){
+    TRACE_ZONE("CubeGrid::marchCubes");
 
-                    if(i >= 0 && i < cellGrid.width && j >= 0 && j < cellGrid.height && k >= 0 && k < cellGrid.depth){
-                        if(i != c.i || j != c.j || k != c.k){
-                            if(i == c.i || j == c.j || k == c.k){
-                                if(controlNodes[i][j][k].active && !visited[i][j][k]){
+    EdgeCache edgeCache(nodes.width, nodes.height);
 
-                                    visited[i][j][k] = true;
-                                    regionNodes.push_back(Coord(i, j, k));
-                                    q.push(regionNodes.back());
+    for(int k = 0; k < depth; k++){
+        // the cubes of the slice k reach the node slices k and k + 1
+        edgeCache.clearSlice(k + 1);
 
-                                }
-                            }
-                        }
-                    }
+        for(int j = 0; j < height; j++){
+            for(int i = 0; i < width; i++){
+                Cube cube(nodes, i, j, k);
+                // save process by calculating vertices of cubes that have at least
+                // one vertex
+                if(cube.configuration != 0 && cube.configuration != 255){
+                    cube.createVertices(vertices, edgeCache, surfaceLevel);
+                    cube.createTriangles(triangles);
+                    if(accumulateNormals)
+                        cube.accumulateNormals(vertices);
                 }
             }
         }
     }
 }
 
-void CubeGrid::marchCubes(vector<Vertex>& vertices)
+void CubeGrid::marchCubesInPlace(vector<Vertex>& vertices, vector<Triangle>& triangles)
 {
-    // create each cubes
+    marchInPlace(vertices, triangles, nullptr);
+}
 
-    // bordering is a 3 bit number representing the relative position
-    // of a cube along the borders of the grid
-    int bordering;
+void CubeGrid::marchCubesInPlace(vector<Vertex>& vertices, vector<Triangle>& triangles, ThreadPool& pool)
+{
+    marchInPlace(vertices, triangles, &pool);
+}
 
-    cubes = new Cube**[width];
-    for(int i = 0; i < width; i++){
-        cubes[i] = new Cube*[height];
-        for(int j = 0; j < height; j++){
-            cubes[i][j] = new Cube[depth];
-            for(int k = 0; k < depth; k++){
-                ControlNode **cubeControlNodes = new ControlNode*[8];
-
-                // add the control nodes of the cube
-
-                // front face vertices
-                cubeControlNodes[0] = &controlNodes[i][j][k];
-                cubeControlNodes[1] = &controlNodes[i][j+1][k];
-                cubeControlNodes[2] = &controlNodes[i+1][j+1][k];
-                cubeControlNodes[3] = &controlNodes[i+1][j][k];
-                // back face, directly opposite to the previous one
-                cubeControlNodes[4] = &controlNodes[i][j][k+1];
-                cubeControlNodes[5] = &controlNodes[i][j+1][k+1];
-                cubeControlNodes[6] = &controlNodes[i+1][j+1][k+1];
-                cubeControlNodes[7] = &controlNodes[i+1][j][k+1];
-
-                bordering = 0;
-                if(i == width-1) bordering |= 1;
-                if(j == height-1) bordering |= 2;
-                if(k == depth-1) bordering |= 4;
-
-                cubes[i][j][k] = Cube(cubeControlNodes, bordering);
-                Cube& cube = cubes[i][j][k];
-                // save process by calculating vertices of cubes that have at least
-                // one vertex
-                if(cube.configuration != 0 && cube.configuration != 255){
-                    cube.createVertices(vertices, surfaceLevel);
-                }
+void CubeGrid::marchInPlace(vector<Vertex>& vertices, vector<Triangle>& triangles, ThreadPool *pool)
+{
+    // classification : count what each slice creates, the prefix sums give
+    // the position of the first vertex of each node slice and of the first
+    // triangle of each cube slice in the output
+
+    TRACE_ZONE("CubeGrid::marchCubesInPlace");
+
+    // a grid without any cube (e.g. built from an empty cell grid) creates
+    // nothing, as with marchCubes
+    if(width < 1 || height < 1 || depth < 1)
+        return;
+
+    vector<size_t> vertexOffsets(nodes.depth + 1, 0);
+    vector<size_t> triangleOffsets(depth + 1, 0);
+
+    auto countSlice = [&](int k){
+        vertexOffsets[k+1] = countSliceVertices(k);
+        if(k < depth)
+            triangleOffsets[k+1] = countSliceTriangles(k);
+    };
+
+    if(pool != nullptr){
+        pool->parallelFor(nodes.depth, countSlice);
+    } else {
+        for(int k = 0; k < nodes.depth; k++){
+            countSlice(k);
+        }
+    }
 
-            }
+    // the offsets are relative to the existing content of the vectors
+    vertexOffsets[0] = vertices.size();
+    triangleOffsets[0] = triangles.size();
+
+    for(int k = 0; k < nodes.depth; k++){
+        vertexOffsets[k+1] += vertexOffsets[k];
+    }
+    for(int k = 0; k < depth; k++){
+        triangleOffsets[k+1] += triangleOffsets[k];
+    }
+
+    vertices.resize(vertexOffsets[nodes.depth]);
+    triangles.resize(triangleOffsets[depth]);
+
+    Vertex *vertexData = vertices.data();
+    Triangle *triangleData = triangles.data();
+
+    if(pool == nullptr){
+        marchSlab(0, depth, vertexOffsets, triangleOffsets, vertexData, triangleData);
+        return;
+    }
+
+    // slabs write disjoint parts of the output and the vertex numbering only
+    // depends on the slices, the result is the same for any number of slabs
+    int slabCount = min(depth, pool->getThreadCount() * 4);
+    if(slabCount <= 0)
+        return;
+
+    pool->parallelFor(slabCount, [&](int slab){
+        int kStart = (int)((long long)depth * slab / slabCount);
+        int kEnd = (int)((long long)depth * (slab + 1) / slabCount);
+        marchSlab(kStart, kEnd, vertexOffsets, triangleOffsets, vertexData, triangleData);
+    });
+}
+
+size_t CubeGrid::countSliceVertices(int k) const
+{
+    size_t count = 0;
+
+    for(int j = 0; j < nodes.height; j++){
+        size_t n = nodes.index(0, j, k);
+
+        for(int i = 0; i < nodes.width; i++, n++){
+            if(i < nodes.width-1 && nodes.crosses(n, 0)) count++;
+            if(j < nodes.height-1 && nodes.crosses(n, 1)) count++;
+            if(k < nodes.depth-1 && nodes.crosses(n, 2)) count++;
         }
     }
 
-    // only necessary vertices were calculated for each cubes
-    // we can determine 3/4 of the edge of each cubes from the surrounding ones
-    // therefore having cubes sharing vertices
+    return count;
+}
+
+size_t CubeGrid::countSliceTriangles(int k) const
+{
+    size_t count = 0;
 
-    for(int i = 0; i < width; i++){
-        for(int j = 0; j < height; j++){
-            for(int k = 0; k < depth; k++){
+    for(int j = 0; j < height; j++){
+        for(int i = 0; i < width; i++){
+            count += triangleCounts[Cube(nodes, i, j, k).configuration];
+        }
+    }
 
-                Cube& cube = cubes[i][j][k];
+    return count;
+}
 
-                if(cube.configuration == 0 || cube.configuration == 255)
-                    continue;
+void CubeGrid::indexSliceVertices(int k, size_t firstVertex, EdgeCache& edgeCache, Vertex *vertices) const
+{
+    // same order as countSliceVertices
 
-                if(i > 0){
-                    cubes[i-1][j][k].edgeNodes[2] = cube.edgeNodes[0];
-                    cubes[i-1][j][k].edgeNodes[11] = cube.edgeNodes[8];
-                    if(j > 0)
-                        cubes[i-1][j-1][k].edgeNodes[10] = cube.edgeNodes[8];
-                }
-                if(j > 0){
-                    cubes[i][j-1][k].edgeNodes[1] = cube.edgeNodes[3];
-                    cubes[i][j-1][k].edgeNodes[9] = cube.edgeNodes[8];
-                    if(k > 0)
-                        cubes[i][j-1][k-1].edgeNodes[5] = cube.edgeNodes[3];
-                }
-                if(k > 0){
-                    cubes[i][j][k-1].edgeNodes[7] = cube.edgeNodes[3];
-                    cubes[i][j][k-1].edgeNodes[4] = cube.edgeNodes[0];
-                    if(i > 0)
-                        cubes[i-1][j][k-1].edgeNodes[6] = cube.edgeNodes[0];
-                }
+    size_t vertexIndex = firstVertex;
+
+    for(int j = 0; j < nodes.height; j++){
+        size_t n = nodes.index(0, j, k);
+
+        for(int i = 0; i < nodes.width; i++, n++){
+            for(int axis = 0; axis < 3; axis++){
+                int& slot = edgeCache.vertex(i, j, k, axis);
 
-                if(cube.bordering != 0){
-                    if((cube.bordering & 1) != 0){
-                        if(k > 0) cubes[i][j][k-1].edgeNodes[6] = cube.edgeNodes[2];
-                        if(j > 0) cubes[i][j-1][k].edgeNodes[10] = cube.edgeNodes[11];
-                    }
-                    if((cube.bordering & 2) != 0){
-                        if(k > 0) cubes[i][j][k-1].edgeNodes[5] = cube.edgeNodes[1];
-                        if(i > 0) cubes[i-1][j][k].edgeNodes[10] = cube.edgeNodes[9];
-                    }
-                    if((cube.bordering & 4) != 0){
-                        if(i > 0) cubes[i-1][j][k].edgeNodes[6] = cube.edgeNodes[4];
-                        if(j > 0) cubes[i][j-1][k].edgeNodes[5] = cube.edgeNodes[7];
-                    }
+                bool inside = axis == 0 ? i < nodes.width-1 : axis == 1 ? j < nodes.height-1 : k < nodes.depth-1;
+
+                if(!inside || !nodes.crosses(n, axis)){
+                    slot = EdgeCache::NO_VERTEX;
+                    continue;
                 }
+
+                if(vertices != nullptr)
+                    vertices[vertexIndex] = Vertex(nodes.edgeVertex(i, j, k, axis, surfaceLevel));
+
+                slot = (int)vertexIndex++;
             }
         }
     }
 }
 
-void CubeGrid::clear(){
+void CubeGrid::marchSlab(int kStart, int kEnd, const vector<size_t>& vertexOffsets, const vector<size_t>& triangleOffsets,
+                         Vertex *vertices, Triangle *triangles) const
+{
+    TRACE_ZONE("CubeGrid::marchSlab");
+
+    EdgeCache edgeCache(nodes.width, nodes.height);
 
-    // free memory from all arrays
+    Triangle *output = triangles + triangleOffsets[kStart];
+
+    indexSliceVertices(kStart, vertexOffsets[kStart], edgeCache, vertices);
+
+    for(int k = kStart; k < kEnd; k++){
+        // the node slice kEnd belongs to the next slab, except for the last one
+        bool ownsNext = k + 1 < kEnd || kEnd == depth;
+        indexSliceVertices(k + 1, vertexOffsets[k + 1], edgeCache, ownsNext ? vertices : nullptr);
 
-    for(int i = 0; i < width; i++){
         for(int j = 0; j < height; j++){
-            for(int k = 0; k < depth; k++){
-                delete[] cubes[i][j][k].edgeNodes;
-                delete[] cubes[i][j][k].controlNodes;
+            for(int i = 0; i < width; i++){
+                Cube cube(nodes, i, j, k);
+                if(cube.configuration != 0 && cube.configuration != 255){
+                    cube.readVertices(edgeCache);
+                    output = cube.createTriangles(output);
+                }
             }
-            delete[] cubes[i][j];
-            delete[] controlNodes[i][j];
         }
-        delete[] cubes[i];
-        delete[] controlNodes[i];
     }
-    delete[] cubes;
-    delete[] controlNodes;
+}
+
+void CubeGrid::clear(){
+
+    // free memory of the control nodes
+
+    nodes = NodeField();
 }
 
 CubeGrid::~CubeGrid()
@@ -0,0 +1,28 @@
+#include "EdgeCache.h"
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+
+EdgeCache::EdgeCache()
+{
+
+}
+
+EdgeCache::EdgeCache(int _width, int _height) : width(_width), height(_height)
+{
+    slots.resize((size_t)2 * width * height * 3, NO_VERTEX);
+}
+
+void EdgeCache::clearSlice(int k)
+{
+    auto first = slots.begin() + (size_t)(k & 1) * width * height * 3;
+    fill(first, first + (size_t)width * height * 3, NO_VERTEX);
+}
+
+EdgeCache::~EdgeCache()
+{
+
+}
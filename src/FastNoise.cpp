@@ -27,12 +27,14 @@
 //
 
 #include "FastNoise.h"
+#include "FastNoiseBatch.h"
 
 #include <math.h>
 #include <assert.h>
 
 #include <algorithm>
 #include <random>
+#include <vector>
 
 const FN_DECIMAL GRAD_X[] =
 {
@@ -212,6 +214,12 @@ void FastNoise::SetSeed(int seed)
 		m_perm[k] = l;
 		m_perm12[j] = m_perm12[j + 256] = m_perm[j] % 12;
 	}
+
+	for (int i = 0; i < 512; i++)
+	{
+		m_permInt[i] = m_perm[i];
+		m_perm12Int[i] = m_perm12[i];
+	}
 }
 
 void FastNoise::CalculateFractalBounding()
@@ -2248,3 +2256,137 @@ void FastNoise::SingleGradientPerturb(unsigned char offset, FN_DECIMAL warpAmp,
 	x += Lerp(lx0x, lx1x, ys) * warpAmp;
 	y += Lerp(ly0x, ly1x, ys) * warpAmp;
 }
+
+// Batch
+
+#if FN_BATCH_X86 && (defined(_MSC_VER) && !defined(__clang__))
+#include <intrin.h>
+#endif
+
+FastNoise::SIMDLevel FastNoise::GetSupportedSIMDLevel()
+{
+	static const SIMDLevel supported = []()
+	{
+#if !FN_BATCH_X86
+		return SIMD_None;
+#elif defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!(info[3] & (1 << 26)))
+			return SIMD_None;
+
+		// the OS must save the ymm (and zmm) registers
+		unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+		if (!avx || (xcr0 & 0x6) != 0x6 || maxLeaf < 7)
+			return SIMD_SSE2;
+
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		bool avx512f = (info[1] & (1 << 16)) != 0;
+
+		if (avx512f && (xcr0 & 0xe6) == 0xe6)
+			return SIMD_AVX512;
+		return avx2 ? SIMD_AVX2 : SIMD_SSE2;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			return SIMD_AVX512;
+		if (__builtin_cpu_supports("avx2"))
+			return SIMD_AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return SIMD_SSE2;
+		return SIMD_None;
+#endif
+	}();
+
+	return supported;
+}
+
+void FastNoise::SetSIMDLevel(SIMDLevel simdLevel)
+{
+	m_simdLevel = std::min(simdLevel, GetSupportedSIMDLevel());
+}
+
+void FastNoise::GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* noiseSet, int count) const
+{
+#ifndef FN_USE_DOUBLES
+	const FastNoiseBatch::Kernels* kernels = nullptr;
+
+	switch (m_simdLevel)
+	{
+	case SIMD_SSE2:
+		kernels = FastNoiseBatch::GetKernelsSSE2();
+		break;
+	case SIMD_AVX2:
+		kernels = FastNoiseBatch::GetKernelsAVX2();
+		break;
+	case SIMD_AVX512:
+		kernels = FastNoiseBatch::GetKernelsAVX512();
+		break;
+	default:
+		break;
+	}
+
+	FastNoiseBatch::Kernel kernel = nullptr;
+
+	if (kernels)
+	{
+		switch (m_noiseType)
+		{
+		case Simplex:
+			kernel = kernels->simplex;
+			break;
+		case Perlin:
+			kernel = kernels->perlin;
+			break;
+		case Value:
+			kernel = kernels->value;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (kernel)
+	{
+		FastNoiseBatch::Tables tables = { m_permInt, m_perm12Int, GRAD_X, GRAD_Y, GRAD_Z, VAL_LUT };
+		kernel(tables, m_interp, m_frequency, x, y, z, noiseSet, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+		noiseSet[i] = GetNoise(x[i], y[i], z[i]);
+}
+
+void FastNoise::FillNoiseSet(FN_DECIMAL* noiseSet, int xStart, int yStart, int zStart, int xSize, int ySize, int zSize, FN_DECIMAL scaleModifier) const
+{
+	if (xSize <= 0 || ySize <= 0 || zSize <= 0)
+		return;
+
+	// the region is evaluated one z row at a time
+	std::vector<FN_DECIMAL> rowX(zSize), rowY(zSize), rowZ(zSize);
+
+	for (int iz = 0; iz < zSize; iz++)
+		rowZ[iz] = (FN_DECIMAL)(zStart + iz) * scaleModifier;
+
+	for (int ix = 0; ix < xSize; ix++)
+	{
+		FN_DECIMAL xf = (FN_DECIMAL)(xStart + ix) * scaleModifier;
+
+		for (int iy = 0; iy < ySize; iy++)
+		{
+			FN_DECIMAL yf = (FN_DECIMAL)(yStart + iy) * scaleModifier;
+
+			std::fill(rowX.begin(), rowX.end(), xf);
+			std::fill(rowY.begin(), rowY.end(), yf);
+
+			GetNoiseSet(rowX.data(), rowY.data(), rowZ.data(), noiseSet + ((size_t)ix * ySize + iy) * zSize, zSize);
+		}
+	}
+}
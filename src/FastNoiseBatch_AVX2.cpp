@@ -0,0 +1,82 @@
+// FastNoiseBatch_AVX2.cpp
+//
+// AVX2 kernels of the FastNoise batch functions, 8 samples per vector.
+// FMA is not enabled so the results match the scalar code.
+
+#include "FastNoiseBatch.h"
+
+#if FN_BATCH_X86
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+// keep separate multiplies and adds, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace
+{
+	struct AVX2
+	{
+		typedef __m256 F;
+		typedef __m256i I;
+		typedef __m256 M;
+
+		static const int Width = 8;
+
+		static inline F Load(const float* p) { return _mm256_loadu_ps(p); }
+		static inline void Store(float* p, F a) { _mm256_storeu_ps(p, a); }
+		static inline F Set1(float a) { return _mm256_set1_ps(a); }
+		static inline I SetI(int a) { return _mm256_set1_epi32(a); }
+
+		static inline F Add(F a, F b) { return _mm256_add_ps(a, b); }
+		static inline F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+		static inline F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+		static inline I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+		static inline I AndI(I a, I b) { return _mm256_and_si256(a, b); }
+		static inline F CvtIF(I a) { return _mm256_cvtepi32_ps(a); }
+
+		// truncation minus one for negative values, as FastFloor
+		static inline I Floor(F a) { return _mm256_add_epi32(_mm256_cvttps_epi32(a), _mm256_castps_si256(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LT_OQ))); }
+
+		static inline M CmpLt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static inline M CmpGe(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+		static inline M MaskAnd(M a, M b) { return _mm256_and_ps(a, b); }
+		static inline M MaskOr(M a, M b) { return _mm256_or_ps(a, b); }
+		static inline M MaskNot(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+		static inline M MaskAndNot(M a, M b) { return _mm256_andnot_ps(a, b); }
+		static inline F Select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+		static inline I OneIfI(M m) { return _mm256_and_si256(_mm256_castps_si256(m), _mm256_set1_epi32(1)); }
+		static inline F OneIfF(M m) { return _mm256_and_ps(m, _mm256_set1_ps(1)); }
+
+		static inline I GatherI(const int* table, I index) { return _mm256_i32gather_epi32(table, index, 4); }
+		static inline F GatherF(const float* table, I index) { return _mm256_i32gather_ps(table, index, 4); }
+	};
+}
+
+#include "FastNoiseBatchKernels.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+const FastNoiseBatch::Kernels* FastNoiseBatch::GetKernelsAVX2()
+{
+	static const Kernels kernels = { Run<AVX2, Simplex<AVX2> >, Run<AVX2, Perlin<AVX2> >, Run<AVX2, Value<AVX2> > };
+	return &kernels;
+}
+
+#else
+
+const FastNoiseBatch::Kernels* FastNoiseBatch::GetKernelsAVX2()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,92 @@
+// FastNoiseBatch_AVX512.cpp
+//
+// AVX-512 kernels of the FastNoise batch functions, 16 samples per vector.
+// Comparisons produce mask registers instead of vectors.
+
+#include "FastNoiseBatch.h"
+
+#if FN_BATCH_X86
+
+// GCC reports the placeholder vectors of the AVX-512 headers as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// keep separate multiplies and adds, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace
+{
+	struct AVX512
+	{
+		typedef __m512 F;
+		typedef __m512i I;
+		typedef __mmask16 M;
+
+		static const int Width = 16;
+
+		static inline F Load(const float* p) { return _mm512_loadu_ps(p); }
+		static inline void Store(float* p, F a) { _mm512_storeu_ps(p, a); }
+		static inline F Set1(float a) { return _mm512_set1_ps(a); }
+		static inline I SetI(int a) { return _mm512_set1_epi32(a); }
+
+		static inline F Add(F a, F b) { return _mm512_add_ps(a, b); }
+		static inline F Sub(F a, F b) { return _mm512_sub_ps(a, b); }
+		static inline F Mul(F a, F b) { return _mm512_mul_ps(a, b); }
+		static inline I AddI(I a, I b) { return _mm512_add_epi32(a, b); }
+		static inline I AndI(I a, I b) { return _mm512_and_si512(a, b); }
+		static inline F CvtIF(I a) { return _mm512_cvtepi32_ps(a); }
+
+		// truncation minus one for negative values, as FastFloor
+		static inline I Floor(F a)
+		{
+			I t = _mm512_cvttps_epi32(a);
+			return _mm512_mask_sub_epi32(t, _mm512_cmp_ps_mask(a, _mm512_setzero_ps(), _CMP_LT_OQ), t, _mm512_set1_epi32(1));
+		}
+
+		static inline M CmpLt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		static inline M CmpGe(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+		static inline M MaskAnd(M a, M b) { return (M)(a & b); }
+		static inline M MaskOr(M a, M b) { return (M)(a | b); }
+		static inline M MaskNot(M a) { return (M)~a; }
+		static inline M MaskAndNot(M a, M b) { return (M)(~a & b); }
+		static inline F Select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+		static inline I OneIfI(M m) { return _mm512_maskz_mov_epi32(m, _mm512_set1_epi32(1)); }
+		static inline F OneIfF(M m) { return _mm512_maskz_mov_ps(m, _mm512_set1_ps(1)); }
+
+		static inline I GatherI(const int* table, I index) { return _mm512_i32gather_epi32(index, table, 4); }
+		static inline F GatherF(const float* table, I index) { return _mm512_i32gather_ps(index, table, 4); }
+	};
+}
+
+#include "FastNoiseBatchKernels.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+const FastNoiseBatch::Kernels* FastNoiseBatch::GetKernelsAVX512()
+{
+	static const Kernels kernels = { Run<AVX512, Simplex<AVX512> >, Run<AVX512, Perlin<AVX512> >, Run<AVX512, Value<AVX512> > };
+	return &kernels;
+}
+
+#else
+
+const FastNoiseBatch::Kernels* FastNoiseBatch::GetKernelsAVX512()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// FastNoiseBatch_SSE2.cpp
+//
+// SSE2 kernels of the FastNoise batch functions, 4 samples per vector.
+// SSE2 has no gather instruction, lookups go through a scalar loop.
+
+#include "FastNoiseBatch.h"
+
+#if FN_BATCH_X86
+
+#include <emmintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+// keep separate multiplies and adds, as in the scalar code
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace
+{
+	struct SSE2
+	{
+		typedef __m128 F;
+		typedef __m128i I;
+		typedef __m128 M;
+
+		static const int Width = 4;
+
+		static inline F Load(const float* p) { return _mm_loadu_ps(p); }
+		static inline void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+		static inline F Set1(float a) { return _mm_set1_ps(a); }
+		static inline I SetI(int a) { return _mm_set1_epi32(a); }
+
+		static inline F Add(F a, F b) { return _mm_add_ps(a, b); }
+		static inline F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+		static inline F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+		static inline I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+		static inline I AndI(I a, I b) { return _mm_and_si128(a, b); }
+		static inline F CvtIF(I a) { return _mm_cvtepi32_ps(a); }
+
+		// truncation minus one for negative values, as FastFloor
+		static inline I Floor(F a) { return _mm_add_epi32(_mm_cvttps_epi32(a), _mm_castps_si128(_mm_cmplt_ps(a, _mm_setzero_ps()))); }
+
+		static inline M CmpLt(F a, F b) { return _mm_cmplt_ps(a, b); }
+		static inline M CmpGe(F a, F b) { return _mm_cmpge_ps(a, b); }
+		static inline M MaskAnd(M a, M b) { return _mm_and_ps(a, b); }
+		static inline M MaskOr(M a, M b) { return _mm_or_ps(a, b); }
+		static inline M MaskNot(M a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+		static inline M MaskAndNot(M a, M b) { return _mm_andnot_ps(a, b); }
+		static inline F Select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+		static inline I OneIfI(M m) { return _mm_and_si128(_mm_castps_si128(m), _mm_set1_epi32(1)); }
+		static inline F OneIfF(M m) { return _mm_and_ps(m, _mm_set1_ps(1)); }
+
+		static inline I GatherI(const int* table, I index)
+		{
+			alignas(16) int i[4];
+			_mm_store_si128((__m128i*)i, index);
+			return _mm_set_epi32(table[i[3]], table[i[2]], table[i[1]], table[i[0]]);
+		}
+
+		static inline F GatherF(const float* table, I index)
+		{
+			alignas(16) int i[4];
+			_mm_store_si128((__m128i*)i, index);
+			return _mm_set_ps(table[i[3]], table[i[2]], table[i[1]], table[i[0]]);
+		}
+	};
+}
+
+#include "FastNoiseBatchKernels.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+const FastNoiseBatch::Kernels* FastNoiseBatch::GetKernelsSSE2()
+{
+	static const Kernels kernels = { Run<SSE2, Simplex<SSE2> >, Run<SSE2, Perlin<SSE2> >, Run<SSE2, Value<SSE2> > };
+	return &kernels;
+}
+
+#else
+
+const FastNoiseBatch::Kernels* FastNoiseBatch::GetKernelsSSE2()
+{
+	return nullptr;
+}
+
+#endif
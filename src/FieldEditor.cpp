@@ -0,0 +1,474 @@
+#include "FieldEditor.h"
+
+#include <CellGrid.h>
+#include <CubeGrid.h>
+#include <NodeField.h>
+#include <Mesh.h>
+#include <VertexFormat.h>
+#include <ThreadPool.h>
+#include <vec3d.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <Trace.h>
+
+using namespace std;
+
+
+// milliseconds elapsed since start
+static double elapsed(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// capacity of a slot for count elements, with room to grow a little in place
+static size_t slotCapacity(size_t count)
+{
+    return count == 0 ? 0 : count + count / 4 + 16;
+}
+
+FieldEditor::FieldEditor(VertexFormat::NormalEncoding normal, int threadCount)
+    : format(VertexFormat::PositionFloat32, normal), pool(threadCount)
+{
+
+}
+
+void FieldEditor::build(const CellGrid& grid, float _cubeSize, float _surfaceLevel)
+{
+    TRACE_ZONE("FieldEditor::build");
+
+    field = grid;
+    cubeSize = _cubeSize;
+    surfaceLevel = _surfaceLevel;
+
+    // a brick of BRICK_SIZE cubes along each axis, the last ones may be smaller
+    bricksX = field.width > 1 ? (field.width - 2) / BRICK_SIZE + 1 : 0;
+    bricksY = field.height > 1 ? (field.height - 2) / BRICK_SIZE + 1 : 0;
+    bricksZ = field.depth > 1 ? (field.depth - 2) / BRICK_SIZE + 1 : 0;
+
+    Brick empty = {};
+    empty.dirty = true;
+
+    bricks.assign((size_t)bricksX * bricksY * bricksZ, empty);
+    dirtyBricks.resize(bricks.size());
+    for(size_t b = 0; b < bricks.size(); b++){
+        dirtyBricks[b] = (int)b;
+    }
+
+    vertexData.clear();
+    indices.clear();
+    wastedVertices = 0;
+    wastedIndices = 0;
+
+    clearChanges();
+    buffersResized = true;
+}
+
+void FieldEditor::addSphere(const vec3d& center, float radius, float strength)
+{
+    applySphere(center, radius, strength);
+}
+
+void FieldEditor::subtractSphere(const vec3d& center, float radius, float strength)
+{
+    applySphere(center, radius, -strength);
+}
+
+void FieldEditor::addBox(const vec3d& minCorner, const vec3d& maxCorner, float strength)
+{
+    applyBox(minCorner, maxCorner, strength);
+}
+
+void FieldEditor::subtractBox(const vec3d& minCorner, const vec3d& maxCorner, float strength)
+{
+    applyBox(minCorner, maxCorner, -strength);
+}
+
+void FieldEditor::smooth(const vec3d& center, float radius, float strength)
+{
+    TRACE_ZONE("FieldEditor::smooth");
+
+    int first[3], last[3];
+    vec3d extent(radius, radius, radius);
+
+    if(!cellRange(center - extent, center + extent, first, last))
+        return;
+
+    // copy the cells of the range and their neighbours so every cell is
+    // smoothed from the values before the edit
+
+    int lo[3], sizes[3];
+    int fieldSizes[3] = { field.width, field.height, field.depth };
+
+    for(int axis = 0; axis < 3; axis++){
+        lo[axis] = max(first[axis] - 1, 0);
+        sizes[axis] = min(last[axis] + 1, fieldSizes[axis] - 1) - lo[axis] + 1;
+    }
+
+    vector<float> values((size_t)sizes[0] * sizes[1] * sizes[2]);
+    auto copied = [&](int i, int j, int k) -> float& {
+        return values[((size_t)(i - lo[0]) * sizes[1] + (j - lo[1])) * sizes[2] + (k - lo[2])];
+    };
+
+    for(int i = lo[0]; i < lo[0] + sizes[0]; i++){
+        for(int j = lo[1]; j < lo[1] + sizes[1]; j++){
+            for(int k = lo[2]; k < lo[2] + sizes[2]; k++){
+                copied(i, j, k) = field.at(i, j, k);
+            }
+        }
+    }
+
+    float radius2 = radius * radius;
+
+    for(int i = first[0]; i <= last[0]; i++){
+        for(int j = first[1]; j <= last[1]; j++){
+            for(int k = first[2]; k <= last[2]; k++){
+                float d2 = vec3d::distance(cellPosition(i, j, k), center);
+                d2 *= d2;
+                if(d2 >= radius2)
+                    continue;
+
+                // mean of the 6 neighbours, the cell itself standing for the
+                // neighbours outside of the field
+                float value = copied(i, j, k);
+                float mean = (copied(i > 0 ? i-1 : i, j, k) + copied(i < field.width-1 ? i+1 : i, j, k)
+                            + copied(i, j > 0 ? j-1 : j, k) + copied(i, j < field.height-1 ? j+1 : j, k)
+                            + copied(i, j, k > 0 ? k-1 : k) + copied(i, j, k < field.depth-1 ? k+1 : k)) / 6.f;
+
+                float t = 1.f - d2 / radius2;
+                field.at(i, j, k) = value + strength * t * t * (mean - value);
+            }
+        }
+    }
+
+    markDirty(first, last);
+}
+
+int FieldEditor::update()
+{
+    TRACE_ZONE("FieldEditor::update");
+
+    if(dirtyBricks.empty())
+        return 0;
+
+    // the bricks are meshed concurrently, then written one after the other
+
+    auto startTime = chrono::high_resolution_clock::now();
+    vector<Mesh> meshes(dirtyBricks.size());
+    pool.parallelFor((int)dirtyBricks.size(), [&](int n){
+        meshBrick(dirtyBricks[n], meshes[n]);
+    });
+    timings.remesh = elapsed(startTime);
+
+    startTime = chrono::high_resolution_clock::now();
+    for(size_t n = 0; n < dirtyBricks.size(); n++){
+        patchBrick(dirtyBricks[n], meshes[n]);
+        bricks[dirtyBricks[n]].dirty = false;
+    }
+
+    // only reclaim the abandoned slots once they take half of the buffers
+    if(wastedVertices > getVertexCount() / 2 || wastedIndices > indices.size() / 2)
+        compact();
+    timings.patch = elapsed(startTime);
+
+    int remeshed = (int)dirtyBricks.size();
+    dirtyBricks.clear();
+
+    return remeshed;
+}
+
+void FieldEditor::clearChanges()
+{
+    buffersResized = false;
+    changedVertices.clear();
+    changedIndices.clear();
+}
+
+float FieldEditor::cellCoordinate(float x, int size) const
+{
+    // the cells are centered around the origin, as the nodes of a CubeGrid
+    return x / cubeSize + (size - 1) / 2.f;
+}
+
+vec3d FieldEditor::cellPosition(int i, int j, int k) const
+{
+    return vec3d((i - (field.width - 1) / 2.f) * cubeSize,
+                 (j - (field.height - 1) / 2.f) * cubeSize,
+                 (k - (field.depth - 1) / 2.f) * cubeSize);
+}
+
+bool FieldEditor::cellRange(const vec3d& minCorner, const vec3d& maxCorner, int first[3], int last[3]) const
+{
+    float lo[3] = { minCorner.x, minCorner.y, minCorner.z };
+    float hi[3] = { maxCorner.x, maxCorner.y, maxCorner.z };
+    int sizes[3] = { field.width, field.height, field.depth };
+
+    for(int axis = 0; axis < 3; axis++){
+        float start = max(ceil(cellCoordinate(lo[axis], sizes[axis])), 0.f);
+        float end = min(floor(cellCoordinate(hi[axis], sizes[axis])), (float)(sizes[axis] - 1));
+        if(start > end)
+            return false;
+
+        first[axis] = (int)start;
+        last[axis] = (int)end;
+    }
+
+    return true;
+}
+
+void FieldEditor::markDirty(const int first[3], const int last[3])
+{
+    // the cell c is a node of the cubes c-1 and c, and its value enters the
+    // gradient of the nodes c-1 and c+1, which are nodes of the cubes c-2 to
+    // c+1 : the bricks of all these cubes are dirty so the neighbour bricks
+    // sharing an edited cell keep the same vertices and normals
+
+    int sizes[3] = { field.width, field.height, field.depth };
+    int firstBrick[3], lastBrick[3];
+
+    for(int axis = 0; axis < 3; axis++){
+        firstBrick[axis] = max(first[axis] - 2, 0) / BRICK_SIZE;
+        lastBrick[axis] = min(last[axis] + 1, sizes[axis] - 2) / BRICK_SIZE;
+    }
+
+    for(int bi = firstBrick[0]; bi <= lastBrick[0]; bi++){
+        for(int bj = firstBrick[1]; bj <= lastBrick[1]; bj++){
+            for(int bk = firstBrick[2]; bk <= lastBrick[2]; bk++){
+                int b = (bi * bricksY + bj) * bricksZ + bk;
+                if(!bricks[b].dirty){
+                    bricks[b].dirty = true;
+                    dirtyBricks.push_back(b);
+                }
+            }
+        }
+    }
+}
+
+void FieldEditor::applySphere(const vec3d& center, float radius, float strength)
+{
+    TRACE_ZONE("FieldEditor::applySphere");
+
+    int first[3], last[3];
+    vec3d extent(radius, radius, radius);
+
+    if(!cellRange(center - extent, center + extent, first, last))
+        return;
+
+    float radius2 = radius * radius;
+
+    for(int i = first[0]; i <= last[0]; i++){
+        for(int j = first[1]; j <= last[1]; j++){
+            for(int k = first[2]; k <= last[2]; k++){
+                float d2 = vec3d::distance(cellPosition(i, j, k), center);
+                d2 *= d2;
+                if(d2 >= radius2)
+                    continue;
+
+                // smooth falloff, with a zero slope on the sphere
+                float t = 1.f - d2 / radius2;
+                field.at(i, j, k) += strength * t * t;
+            }
+        }
+    }
+
+    markDirty(first, last);
+}
+
+void FieldEditor::applyBox(const vec3d& minCorner, const vec3d& maxCorner, float strength)
+{
+    TRACE_ZONE("FieldEditor::applyBox");
+
+    int first[3], last[3];
+
+    if(!cellRange(minCorner, maxCorner, first, last))
+        return;
+
+    for(int i = first[0]; i <= last[0]; i++){
+        for(int j = first[1]; j <= last[1]; j++){
+            for(int k = first[2]; k <= last[2]; k++){
+                field.at(i, j, k) += strength;
+            }
+        }
+    }
+
+    markDirty(first, last);
+}
+
+void FieldEditor::meshBrick(int brick, Mesh& mesh) const
+{
+    TRACE_ZONE("FieldEditor::meshBrick");
+
+    int bi = brick / (bricksY * bricksZ);
+    int bj = (brick / bricksZ) % bricksY;
+    int bk = brick % bricksZ;
+
+    int i0 = bi * BRICK_SIZE, j0 = bj * BRICK_SIZE, k0 = bk * BRICK_SIZE;
+
+    // nodes of the cubes of the brick, the last ones shared with the next brick
+    int width = min(BRICK_SIZE, field.width - 1 - i0) + 1;
+    int height = min(BRICK_SIZE, field.height - 1 - j0) + 1;
+    int depth = min(BRICK_SIZE, field.depth - 1 - k0) + 1;
+
+    CellGrid nodes(width, height, depth);
+    for(int i = 0; i < width; i++){
+        for(int j = 0; j < height; j++){
+            for(int k = 0; k < depth; k++){
+                nodes.at(i, j, k) = field.at(i0 + i, j0 + j, k0 + k);
+            }
+        }
+    }
+
+    // no region filtering, it would need the whole field
+    CubeGrid cubeGrid;
+    cubeGrid.generateGrid(nodes, cubeSize, surfaceLevel, 0);
+
+    // the normals are computed once below, from the nodes around the brick too
+    mesh.normalMode = Mesh::NoNormals;
+    mesh.generateMesh(cubeGrid, 0, true);
+    mesh.optimizeVertexCache();
+    mesh.optimizeVertexFetch();
+
+    // the normals are the gradient of the nodes of the brick and of one more
+    // node around it, where the field has some, so the central differences on
+    // the brick faces are the ones of a mesh of the whole field
+    int gi0 = max(i0 - 1, 0), gj0 = max(j0 - 1, 0), gk0 = max(k0 - 1, 0);
+    int ghostWidth = min(i0 + width, field.width - 1) - gi0 + 1;
+    int ghostHeight = min(j0 + height, field.height - 1) - gj0 + 1;
+    int ghostDepth = min(k0 + depth, field.depth - 1) - gk0 + 1;
+
+    NodeField ghostNodes(ghostWidth, ghostHeight, ghostDepth, cubeSize);
+    for(int k = 0; k < ghostDepth; k++){
+        for(int j = 0; j < ghostHeight; j++){
+            for(int i = 0; i < ghostWidth; i++){
+                ghostNodes.value(i, j, k) = field.at(gi0 + i, gj0 + j, gk0 + k);
+            }
+        }
+    }
+
+    vec3d ghostCenter((gi0 - i0 + (ghostWidth - width) / 2.f) * cubeSize,
+                      (gj0 - j0 + (ghostHeight - height) / 2.f) * cubeSize,
+                      (gk0 - k0 + (ghostDepth - depth) / 2.f) * cubeSize);
+    mesh.calculateGradientNormals(ghostNodes, ghostCenter);
+
+    // the brick mesh is centered around the origin, move it to its place in the field
+    vec3d offset((i0 + (width - field.width) / 2.f) * cubeSize,
+                 (j0 + (height - field.height) / 2.f) * cubeSize,
+                 (k0 + (depth - field.depth) / 2.f) * cubeSize);
+
+    for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it){
+        it->pos += offset;
+    }
+}
+
+void FieldEditor::patchBrick(int b, const Mesh& mesh)
+{
+    Brick& brick = bricks[b];
+    size_t stride = format.stride();
+
+    size_t vertexCount = mesh.vertices.size();
+    size_t indexCount = mesh.triangles.size() * 3;
+
+    // move the slots growing past their capacity to the end of the buffers
+
+    if(vertexCount > brick.vertexCapacity){
+        wastedVertices += brick.vertexCapacity;
+        brick.firstVertex = getVertexCount();
+        brick.vertexCapacity = slotCapacity(vertexCount);
+        vertexData.resize((brick.firstVertex + brick.vertexCapacity) * stride);
+        buffersResized = true;
+    }
+
+    if(indexCount > brick.indexCapacity){
+        // the abandoned slot is still drawn, empty it
+        if(brick.indexCapacity > 0){
+            brick.indexCount = 0;
+            padIndices(brick);
+            if(!buffersResized)
+                changedIndices.push_back({ brick.firstIndex, brick.indexCapacity });
+        }
+
+        wastedIndices += brick.indexCapacity;
+        brick.firstIndex = indices.size();
+        brick.indexCapacity = slotCapacity(mesh.triangles.size()) * 3;
+        indices.resize(brick.firstIndex + brick.indexCapacity);
+        buffersResized = true;
+    }
+
+    brick.vertexCount = vertexCount;
+    brick.indexCount = indexCount;
+
+    if(vertexCount > 0)
+        mesh.packVertices(format, &vertexData[brick.firstVertex * stride]);
+
+    // a brick which never had triangles has no index slot
+    if(brick.indexCapacity > 0){
+        uint32_t *slot = &indices[brick.firstIndex];
+        uint32_t firstVertex = (uint32_t)brick.firstVertex;
+
+        for(auto it = mesh.triangles.begin(); it != mesh.triangles.end(); ++it){
+            *slot++ = firstVertex + it->a;
+            *slot++ = firstVertex + it->b;
+            *slot++ = firstVertex + it->c;
+        }
+
+        padIndices(brick);
+    }
+
+    // the whole index slot is rewritten, the vertices only up to their count
+    if(!buffersResized){
+        if(vertexCount > 0)
+            changedVertices.push_back({ brick.firstVertex, vertexCount });
+        if(brick.indexCapacity > 0)
+            changedIndices.push_back({ brick.firstIndex, brick.indexCapacity });
+    }
+}
+
+void FieldEditor::padIndices(const Brick& brick)
+{
+    // an index slot only exists once its brick had triangles, so it has vertices
+    fill(indices.begin() + brick.firstIndex + brick.indexCount,
+         indices.begin() + brick.firstIndex + brick.indexCapacity,
+         (uint32_t)brick.firstVertex);
+}
+
+void FieldEditor::compact()
+{
+    TRACE_ZONE("FieldEditor::compact");
+
+    size_t stride = format.stride();
+    vector<uint8_t> packedVertices;
+    vector<uint32_t> packedIndices;
+
+    packedVertices.reserve(vertexData.size() - wastedVertices * stride);
+    packedIndices.reserve(indices.size() - wastedIndices);
+
+    for(auto it = bricks.begin(); it != bricks.end(); ++it){
+        size_t firstVertex = packedVertices.size() / stride;
+        size_t firstIndex = packedIndices.size();
+
+        packedVertices.insert(packedVertices.end(), vertexData.begin() + it->firstVertex * stride,
+                              vertexData.begin() + (it->firstVertex + it->vertexCapacity) * stride);
+
+        for(size_t n = 0; n < it->indexCapacity; n++){
+            packedIndices.push_back((uint32_t)(indices[it->firstIndex + n] - it->firstVertex + firstVertex));
+        }
+
+        it->firstVertex = firstVertex;
+        it->firstIndex = firstIndex;
+    }
+
+    vertexData.swap(packedVertices);
+    indices.swap(packedIndices);
+    wastedVertices = 0;
+    wastedIndices = 0;
+
+    buffersResized = true;
+    changedVertices.clear();
+    changedIndices.clear();
+}
+
+FieldEditor::~FieldEditor()
+{
+
+}
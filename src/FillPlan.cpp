@@ -0,0 +1,55 @@
+#include "FillPlan.h"
+
+#include <vector>
+#include <math.h>
+
+using namespace std;
+
+
+FillPlan::FillPlan()
+{
+
+}
+
+FillPlan::FillPlan(int _width, int _height, int _depth, int _octaves, float lacunarity, float persistance, float scale,
+                   bool closedEdges)
+    : width(_width), height(_height), depth(_depth), octaves(_octaves)
+{
+    for(int u = 0; u < octaves; u++){
+        frequencies.push_back(pow(lacunarity, u) * scale);
+        amplitudes.push_back(pow(persistance, u));
+    }
+
+    if(closedEdges){
+        weightX = axisWeights(width);
+        weightY = axisWeights(height);
+        weightZ = axisWeights(depth);
+    } else {
+        weightX.assign(width, 0.f);
+        weightY.assign(height, 0.f);
+        weightZ.assign(depth, 0.f);
+    }
+}
+
+vector<float> FillPlan::axisWeights(int size)
+{
+    // the weight grows from 0 to 1 on the 2 outer layers of the axis,
+    // clamping each axis before taking the max is the same as clamping the max
+
+    vector<float> weights(size);
+    float pos;
+
+    for(int i = 0; i < size; i++){
+        pos = fabs((float)i - (float)size / 2.f + 0.5f) * 2.f;
+        pos += -size + 2.f;
+
+        weights[i] = pos < 0.f ? 0.f : pos > 1.f ? 1.f : pos;
+    }
+
+    return weights;
+}
+
+FillPlan::~FillPlan()
+{
+
+}
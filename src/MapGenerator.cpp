@@ -0,0 +1,85 @@
+#include "MapGenerator.h"
+
+#include <FastNoise.h>
+#include <CellGrid.h>
+#include <CubeGrid.h>
+#include <Mesh.h>
+#include <ThreadPool.h>
+#include <chrono>
+#include <Trace.h>
+#include <MemoryTracker.h>
+
+using namespace std;
+
+
+// milliseconds elapsed since start
+static double elapsed(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+MapGenerator::MapGenerator(int threadCount) : timings(), memory(), cacheBefore(), cacheAfter(), pool(threadCount)
+{
+    noise.SetNoiseType(FastNoise::Simplex);
+}
+
+void MapGenerator::generate(int seed)
+{
+    TRACE_ZONE("MapGenerator::generate");
+
+    auto startTime = chrono::high_resolution_clock::now();
+
+    // delete previous mesh data
+    mesh.clear();
+    mesh.normalMode = normalMode;
+    // configure noise to the seed
+    noise.SetSeed(seed);
+
+    // fill the 3D scalar field, the grid is only reallocated when resized
+    auto stepTime = chrono::high_resolution_clock::now();
+    MemoryMeasure stepMemory;
+    if(cellGrid.width != gridWidth || cellGrid.height != gridHeight || cellGrid.depth != gridDepth)
+        cellGrid = CellGrid(gridWidth, gridHeight, gridDepth);
+    cellGrid.fillGrid(noise, octaves, lacunarity, persistance, noiseScale, pool);
+    timings.fillGrid = elapsed(stepTime);
+    memory.fillGrid = stepMemory.finish();
+    memory.cellGridBytes = cellGrid.memorySize();
+
+    // generate the cube grid according to that scalar field
+    stepTime = chrono::high_resolution_clock::now();
+    stepMemory = MemoryMeasure();
+    cubeGrid.generateGrid(cellGrid, cubeSize, surfaceLevel, minRegionSize, pool);
+    timings.generateGrid = elapsed(stepTime);
+    memory.generateGrid = stepMemory.finish();
+    memory.nodeBytes = cubeGrid.nodes.memorySize();
+
+    // march the cubes and process the resulting mesh
+    stepTime = chrono::high_resolution_clock::now();
+    stepMemory = MemoryMeasure();
+    mesh.generateMesh(cubeGrid, minRegionSize, pool);
+    timings.generateMesh = elapsed(stepTime);
+
+    // free memory of useless data
+    cubeGrid.clear();
+    memory.generateMesh = stepMemory.finish();
+
+    // reorder the mesh for the vertex cache
+    stepTime = chrono::high_resolution_clock::now();
+    stepMemory = MemoryMeasure();
+    cacheBefore = mesh.getCacheStatistics();
+    if(optimizeMesh){
+        mesh.optimizeVertexCache();
+        mesh.optimizeVertexFetch();
+    }
+    cacheAfter = mesh.getCacheStatistics();
+    timings.optimizeMesh = elapsed(stepTime);
+    memory.optimizeMesh = stepMemory.finish();
+    memory.meshBytes = mesh.memorySize();
+
+    timings.total = elapsed(startTime);
+}
+
+MapGenerator::~MapGenerator()
+{
+
+}
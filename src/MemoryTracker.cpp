@@ -0,0 +1,186 @@
+#include "MemoryTracker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+
+namespace
+{
+    atomic<size_t> liveBytes(0);
+    atomic<size_t> peakBytes(0);
+    atomic<size_t> allocatedBytes(0);
+    atomic<size_t> allocationCount(0);
+}
+
+bool MemoryTracker::enabled()
+{
+#ifdef MC_TRACK_MEMORY
+    return true;
+#else
+    return false;
+#endif
+}
+
+MemoryTracker::Counters MemoryTracker::counters()
+{
+    Counters counters;
+    counters.liveBytes = liveBytes.load(memory_order_relaxed);
+    counters.peakBytes = peakBytes.load(memory_order_relaxed);
+    counters.allocatedBytes = allocatedBytes.load(memory_order_relaxed);
+    counters.allocationCount = allocationCount.load(memory_order_relaxed);
+    return counters;
+}
+
+void MemoryTracker::resetPeak()
+{
+    peakBytes.store(liveBytes.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+size_t MemoryTracker::peakResidentBytes()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss;
+#else
+    // kilobytes on Linux
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+void MemoryTracker::recordAllocation(size_t size)
+{
+    size_t live = liveBytes.fetch_add(size, memory_order_relaxed) + size;
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    allocationCount.fetch_add(1, memory_order_relaxed);
+
+    size_t peak = peakBytes.load(memory_order_relaxed);
+    while(live > peak && !peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)){
+    }
+}
+
+void MemoryTracker::recordRelease(size_t size)
+{
+    liveBytes.fetch_sub(size, memory_order_relaxed);
+}
+
+MemoryMeasure::MemoryMeasure()
+{
+    MemoryTracker::resetPeak();
+    start = MemoryTracker::counters();
+}
+
+MemoryTracker::Usage MemoryMeasure::finish() const
+{
+    MemoryTracker::Counters end = MemoryTracker::counters();
+
+    MemoryTracker::Usage usage;
+    usage.allocatedBytes = end.allocatedBytes - start.allocatedBytes;
+    usage.allocationCount = end.allocationCount - start.allocationCount;
+    usage.peakBytes = end.peakBytes;
+    usage.retainedBytes = (long long)end.liveBytes - (long long)start.liveBytes;
+    return usage;
+}
+
+#ifdef MC_TRACK_MEMORY
+
+// Replacement of the global allocation functions. Each block starts with
+// a header holding the pointer returned by malloc and the requested size,
+// just before the address given to the program, aligned as requested.
+
+namespace
+{
+    struct BlockHeader
+    {
+        void *raw;
+        size_t size;
+    };
+
+    void* trackedAllocate(size_t size, size_t alignment)
+    {
+        if(alignment < alignof(max_align_t))
+            alignment = alignof(max_align_t);
+
+        // the header and the alignment padding must not wrap the size around
+        if(size > SIZE_MAX - sizeof(BlockHeader) - (alignment - 1))
+            return nullptr;
+
+        void *raw = malloc(size + sizeof(BlockHeader) + alignment - 1);
+        if(raw == nullptr)
+            return nullptr;
+
+        uintptr_t address = (uintptr_t)raw + sizeof(BlockHeader);
+        address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+        BlockHeader *header = (BlockHeader*)address - 1;
+        header->raw = raw;
+        header->size = size;
+
+        MemoryTracker::recordAllocation(size);
+
+        return (void*)address;
+    }
+
+    void trackedRelease(void *pointer)
+    {
+        if(pointer == nullptr)
+            return;
+
+        BlockHeader *header = (BlockHeader*)pointer - 1;
+        MemoryTracker::recordRelease(header->size);
+        free(header->raw);
+    }
+
+    void* allocateOrThrow(size_t size, size_t alignment)
+    {
+        // new handlers may free memory, try again until there is none
+        while(true){
+            void *pointer = trackedAllocate(size, alignment);
+            if(pointer != nullptr)
+                return pointer;
+
+            new_handler handler = get_new_handler();
+            if(handler == nullptr)
+                throw bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new(size_t size) { return allocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return allocateOrThrow(size, 0); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return trackedAllocate(size, 0); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return trackedAllocate(size, 0); }
+void* operator new(size_t size, align_val_t alignment) { return allocateOrThrow(size, (size_t)alignment); }
+void* operator new[](size_t size, align_val_t alignment) { return allocateOrThrow(size, (size_t)alignment); }
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept { return trackedAllocate(size, (size_t)alignment); }
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept { return trackedAllocate(size, (size_t)alignment); }
+
+void operator delete(void *pointer) noexcept { trackedRelease(pointer); }
+void operator delete[](void *pointer) noexcept { trackedRelease(pointer); }
+void operator delete(void *pointer, const nothrow_t&) noexcept { trackedRelease(pointer); }
+void operator delete[](void *pointer, const nothrow_t&) noexcept { trackedRelease(pointer); }
+void operator delete(void *pointer, size_t) noexcept { trackedRelease(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { trackedRelease(pointer); }
+void operator delete(void *pointer, align_val_t) noexcept { trackedRelease(pointer); }
+void operator delete[](void *pointer, align_val_t) noexcept { trackedRelease(pointer); }
+void operator delete(void *pointer, align_val_t, const nothrow_t&) noexcept { trackedRelease(pointer); }
+void operator delete[](void *pointer, align_val_t, const nothrow_t&) noexcept { trackedRelease(pointer); }
+void operator delete(void *pointer, size_t, align_val_t) noexcept { trackedRelease(pointer); }
+void operator delete[](void *pointer, size_t, align_val_t) noexcept { trackedRelease(pointer); }
+
+#endif // MC_TRACK_MEMORY
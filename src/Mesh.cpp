@@ -2,184 +2,520 @@
 
 #include <Table.h>
 #include <Cube.h>
-#include <queue>
-#include <set>
 #include <algorithm>
+#include <ThreadPool.h>
+#include <UnionFind.h>
+#include <VertexFormat.h>
+#include <math.h>
+#include <string.h>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <Trace.h>
 
 using namespace std;
 
+// milliseconds elapsed since start
+static double elapsed(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
 
 Mesh::Mesh()
 {
 
 }
 
-void Mesh::generateMesh(CubeGrid& cubeGrid, unsigned int minTriangleCount)
+void Mesh::generateMesh(CubeGrid& cubeGrid, unsigned int minTriangleCount, bool inPlace)
 {
+    TRACE_ZONE("Mesh::generateMesh");
+
     dimX = cubeGrid.width * cubeGrid.cubeSize;
     dimY = cubeGrid.height * cubeGrid.cubeSize;
     dimZ = cubeGrid.depth * cubeGrid.cubeSize;
 
-    for(int i = 0; i < cubeGrid.width; i++){
-        for(int j = 0; j < cubeGrid.height; j++){
-            for(int k = 0; k < cubeGrid.depth; k++){
-                triangulateCube(cubeGrid.cubes[i][j][k]);
-            }
-        }
-    }
+    auto startTime = chrono::high_resolution_clock::now();
+    if(inPlace)
+        cubeGrid.marchCubesInPlace(vertices, triangles);
+    else
+        cubeGrid.marchCubes(vertices, triangles, normalMode == AreaWeighted);
+    timings.marchCubes = elapsed(startTime);
+
+    processTriangles(cubeGrid, minTriangleCount, !inPlace);
+}
+
+void Mesh::generateMesh(CubeGrid& cubeGrid, unsigned int minTriangleCount, ThreadPool& pool)
+{
+    TRACE_ZONE("Mesh::generateMesh");
+
+    dimX = cubeGrid.width * cubeGrid.cubeSize;
+    dimY = cubeGrid.height * cubeGrid.cubeSize;
+    dimZ = cubeGrid.depth * cubeGrid.cubeSize;
 
-    assignSharedTriangles();
+    auto startTime = chrono::high_resolution_clock::now();
+    cubeGrid.marchCubesInPlace(vertices, triangles, pool);
+    timings.marchCubes = elapsed(startTime);
 
-    if(minTriangleCount > 0){
+    processTriangles(cubeGrid, minTriangleCount, false);
+}
+
+void Mesh::processTriangles(CubeGrid& cubeGrid, unsigned int minTriangleCount, bool normalsAccumulated)
+{
+    // the filtered regions share no vertex with the kept ones, so normals
+    // accumulated before the filtering are only made of kept triangles
+
+    auto startTime = chrono::high_resolution_clock::now();
+    if(minTriangleCount > 0)
         ignoreSmallRegions(minTriangleCount);
-        // reassign sharing because the triangles vector may have changed
-        sharedTriangles.clear();
-        assignSharedTriangles();
+    timings.ignoreSmallRegions = elapsed(startTime);
+
+    timings.adjacency = 0.;
+    startTime = chrono::high_resolution_clock::now();
+
+    switch(normalMode){
+        case FaceAverage:
+            assignSharedTriangles();
+            timings.adjacency = elapsed(startTime);
+            startTime = chrono::high_resolution_clock::now();
+            calculateNormals();
+            break;
+        case AreaWeighted:
+            if(!normalsAccumulated)
+                accumulateNormals();
+            normalizeNormals();
+            break;
+        case FieldGradient:
+            calculateGradientNormals(cubeGrid.nodes);
+            break;
+        case NoNormals:
+            break;
     }
 
-    calculateNormals();
+    timings.normals = elapsed(startTime);
 }
 
 void Mesh::clear()
 {
     vertices.clear();
     triangles.clear();
+    sharedOffsets.clear();
     sharedTriangles.clear();
 }
 
 void Mesh::calculateNormals()
 {
+    TRACE_ZONE("Mesh::calculateNormals");
+
     // the normal of each vertex is calculated as the average of each normals
     // of the triangles sharing this vertex
 
-    for(auto it = triangles.begin(); it != triangles.end(); ++it){
-        Triangle& triangle = *it;
+    vector<vec3d> triangleNormals(triangles.size());
+
+    for(unsigned int i = 0; i < triangles.size(); i++){
+        Triangle& triangle = triangles[i];
 
         vec3d& v1 = vertices[triangle.a].pos;
         vec3d& v2 = vertices[triangle.b].pos;
         vec3d& v3 = vertices[triangle.c].pos;
 
-        triangle.normal = vec3d::cross(v2-v1, v3-v1);
-        triangle.normal.normalize();
+        triangleNormals[i] = vec3d::cross(v2-v1, v3-v1);
+        triangleNormals[i].normalize();
     }
 
     for(unsigned int i = 0; i < vertices.size(); i++){
         Vertex& vertex = vertices[i];
 
-        for(auto it = sharedTriangles[i].begin(); it != sharedTriangles[i].end(); ++it){
-            vertex.normal += triangles[*it].normal;
+        for(unsigned int n = sharedOffsets[i]; n < sharedOffsets[i+1]; n++){
+            vertex.normal += triangleNormals[sharedTriangles[n]];
         }
 
         vertex.normal.normalize();
     }
 }
 
-void Mesh::assignSharedTriangles()
+void Mesh::accumulateNormals()
 {
-    sharedTriangles.resize(vertices.size());
+    TRACE_ZONE("Mesh::accumulateNormals");
 
-    for(unsigned int i = 0; i < triangles.size(); i++){
-        sharedTriangles[triangles[i].a].push_back(i);
-        sharedTriangles[triangles[i].b].push_back(i);
-        sharedTriangles[triangles[i].c].push_back(i);
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        Vertex& v1 = vertices[it->a];
+        Vertex& v2 = vertices[it->b];
+        Vertex& v3 = vertices[it->c];
+
+        // the length of the cross product is twice the area of the triangle
+        vec3d normal = vec3d::cross(v2.pos - v1.pos, v3.pos - v1.pos);
+
+        v1.normal += normal;
+        v2.normal += normal;
+        v3.normal += normal;
     }
 }
 
-void Mesh::triangulateCube(Cube& cube)
+void Mesh::calculateGradientNormals(const NodeField& nodes, const vec3d& center)
 {
-    const int *triConfig = triTable[cube.configuration];
+    TRACE_ZONE("Mesh::calculateGradientNormals");
 
-    int a, b, c;
+    // the values increase towards the inside of the shape
 
-    for(int i = 0; triConfig[i] != -1; i += 3){
-        a = cube.edgeNodes[triConfig[i]];
-        b = cube.edgeNodes[triConfig[i+1]];
-        c = cube.edgeNodes[triConfig[i+2]];
-        triangles.push_back(Triangle(a, b, c));
+    for(auto it = vertices.begin(); it != vertices.end(); ++it){
+        it->normal = -1.f * nodes.gradient(it->pos - center);
+        it->normal.normalize();
+    }
+}
+
+void Mesh::normalizeNormals()
+{
+    for(auto it = vertices.begin(); it != vertices.end(); ++it){
+        it->normal.normalize();
+    }
+}
+
+void Mesh::assignSharedTriangles()
+{
+    TRACE_ZONE("Mesh::assignSharedTriangles");
+
+    // count the triangles of each vertex, the prefix sum gives where the
+    // list of each vertex starts, then fill the lists
+
+    sharedOffsets.assign(vertices.size() + 1, 0);
+
+    for(unsigned int i = 0; i < triangles.size(); i++){
+        sharedOffsets[triangles[i].a + 1]++;
+        sharedOffsets[triangles[i].b + 1]++;
+        sharedOffsets[triangles[i].c + 1]++;
+    }
+
+    for(unsigned int i = 0; i < vertices.size(); i++){
+        sharedOffsets[i+1] += sharedOffsets[i];
+    }
+
+    sharedTriangles.resize(triangles.size() * 3);
+
+    // next free position in the list of each vertex
+    vector<unsigned int> fill(sharedOffsets.begin(), sharedOffsets.end() - 1);
+
+    for(unsigned int i = 0; i < triangles.size(); i++){
+        sharedTriangles[fill[triangles[i].a]++] = i;
+        sharedTriangles[fill[triangles[i].b]++] = i;
+        sharedTriangles[fill[triangles[i].c]++] = i;
     }
 }
 
 void Mesh::ignoreSmallRegions(unsigned int minTriangleCount)
 {
-    // Apply floodfill on each non already visited vertices to get a
-    // vector of triangles (referred as their index) to delete.
-    // This step completes the per node floodfill as it clears features
+    TRACE_ZONE("Mesh::ignoreSmallRegions");
+
+    // The vertices of a triangle belong to the same region : merge them in
+    // a union-find structure, count the triangles of each region, then keep
+    // the triangles of the big enough regions in their original order.
+    // This step completes the per node filtering as it clears features
     // not detected in the previous step.
 
-    bool *visited = new bool[vertices.size()];
-    for(unsigned int i = 0; i < vertices.size(); i++){
-        visited[i] = false;
+    UnionFind regions(vertices.size());
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        regions.unite(it->a, it->b);
+        regions.unite(it->a, it->c);
     }
 
-    // list of all triangles that should be deleted
+    // number of triangles of each region, stored at its root
+    vector<unsigned int> regionTriangles(vertices.size(), 0);
 
-    vector<int> trianglesToDelete;
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        regionTriangles[regions.find(it->a)]++;
+    }
 
-    for(unsigned int i = 0; i < vertices.size(); i++){
-        if(!visited[i]){
-            visited[i] = true;
+    auto kept = triangles.begin();
 
-            set<int> regionTriangles;
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        if(regionTriangles[regions.find(it->a)] >= minTriangleCount)
+            *kept++ = *it;
+    }
 
-            getRegionTriangles(i, visited, regionTriangles);
+    triangles.erase(kept, triangles.end());
 
-            if(regionTriangles.size() < minTriangleCount){
-                for(auto tri = regionTriangles.begin(); tri != regionTriangles.end(); ++tri){
-                    trianglesToDelete.push_back(*tri);
-                }
-            }
-        }
+    // the vertices of the removed regions aren't used anymore : remove them,
+    // keeping the order of the others so the mesh stays deterministic
+
+    vector<bool> used(vertices.size(), false);
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        used[it->a] = used[it->b] = used[it->c] = true;
     }
 
-    delete[] visited;
+    vector<unsigned int> remap(vertices.size());
+    unsigned int count = 0;
+
+    for(size_t v = 0; v < vertices.size(); v++){
+        remap[v] = count;
+        if(used[v])
+            vertices[count++] = vertices[v];
+    }
 
-    // delete the triangles from the triangles vector
+    if(count == vertices.size())
+        return;
 
-    sort(trianglesToDelete.begin(), trianglesToDelete.end());
+    vertices.resize(count);
 
-    for(auto tri = trianglesToDelete.end() - 1; tri != trianglesToDelete.begin() - 1; tri--){
-        iter_swap(triangles.begin() + (*tri), triangles.end() - 1);
-        triangles.pop_back();
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        it->a = remap[it->a];
+        it->b = remap[it->b];
+        it->c = remap[it->c];
     }
 }
 
-void Mesh::getRegionTriangles(int startVertex, bool *visited, set<int>& regionTriangles)
+// score of a vertex in the Forsyth vertex cache optimization : vertices
+// recently used score higher, the 3 last ones a fixed value so the next
+// triangle doesn't just reuse the same edge, and vertices with few remaining
+// triangles get a boost so they are finished instead of left alone
+static float vertexCacheScore(int cachePosition, unsigned int remainingTriangles, unsigned int cacheSize)
 {
-    // floodfill algorithm visiting all vertices of a connected shape
+    if(remainingTriangles == 0)
+        return -1.f;
+
+    float score = 0.f;
+
+    if(cachePosition >= 0){
+        if(cachePosition < 3){
+            score = 0.75f;
+        } else {
+            float scale = 1.f - (float)(cachePosition - 3) / (float)(cacheSize - 3);
+            score = powf(scale, 1.5f);
+        }
+    }
+
+    return score + 2.f / sqrtf((float)remainingTriangles);
+}
+
+void Mesh::optimizeVertexCache(unsigned int cacheSize)
+{
+    TRACE_ZONE("Mesh::optimizeVertexCache");
+
+    // Greedy ordering from Tom Forsyth's "Linear-speed vertex cache
+    // optimisation" : a LRU cache is simulated and the next triangle is
+    // the best scored one among the triangles of the cached vertices
+
+    unsigned int triangleCount = triangles.size();
+
+    if(triangleCount == 0 || cacheSize < 4)
+        return;
+
+    // live triangles of each vertex, in compressed sparse row form : the
+    // first remaining[v] entries of the vertex list are the ones not emitted
+    vector<unsigned int> offsets(vertices.size() + 1, 0);
+    vector<unsigned int> remaining(vertices.size(), 0);
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        remaining[it->a]++;
+        remaining[it->b]++;
+        remaining[it->c]++;
+    }
+
+    for(unsigned int v = 0; v < vertices.size(); v++){
+        offsets[v+1] = offsets[v] + remaining[v];
+    }
+
+    vector<unsigned int> adjacency(offsets.back());
+    vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+
+    for(unsigned int t = 0; t < triangleCount; t++){
+        adjacency[fill[triangles[t].a]++] = t;
+        adjacency[fill[triangles[t].b]++] = t;
+        adjacency[fill[triangles[t].c]++] = t;
+    }
 
-    queue<int> vertQ;
+    vector<int> cachePosition(vertices.size(), -1);
+    vector<float> vertexScore(vertices.size());
+    vector<float> triangleScore(triangleCount);
+    vector<bool> emitted(triangleCount, false);
 
-    int vertex;
-    int va, vb, vc;
+    for(unsigned int v = 0; v < vertices.size(); v++){
+        vertexScore[v] = vertexCacheScore(-1, remaining[v], cacheSize);
+    }
+
+    for(unsigned int t = 0; t < triangleCount; t++){
+        triangleScore[t] = vertexScore[triangles[t].a] + vertexScore[triangles[t].b] + vertexScore[triangles[t].c];
+    }
+
+    vector<Triangle> ordered;
+    ordered.reserve(triangleCount);
 
-    vertQ.push(startVertex);
+    // the cache holds cacheSize vertices, plus the 3 pushed by a triangle
+    // before the oldest ones are evicted
+    vector<unsigned int> cache, nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
 
-    while(!vertQ.empty()){
+    unsigned int best = 0;
+    unsigned int cursor = 0;
 
-        vertex = vertQ.front();
-        vertQ.pop();
+    for(unsigned int t = 1; t < triangleCount; t++){
+        if(triangleScore[t] > triangleScore[best])
+            best = t;
+    }
+
+    while(true){
+        const Triangle& triangle = triangles[best];
+        const unsigned int corners[3] = { triangle.a, triangle.b, triangle.c };
 
-        for(auto tri = sharedTriangles[vertex].begin(); tri != sharedTriangles[vertex].end(); ++tri){
-            regionTriangles.insert(*tri);
+        ordered.push_back(triangle);
+        emitted[best] = true;
 
-            va = triangles[*tri].a;
-            vb = triangles[*tri].b;
-            vc = triangles[*tri].c;
+        // remove the triangle from the live lists of its vertices
+        for(int c = 0; c < 3; c++){
+            unsigned int v = corners[c];
+            unsigned int *first = &adjacency[offsets[v]];
+            unsigned int *last = first + remaining[v] - 1;
 
-            if(!visited[va]){
-                visited[va] = true;
-                vertQ.push(va);
+            for(unsigned int *it = first; it <= last; ++it){
+                if(*it == best){
+                    swap(*it, *last);
+                    break;
+                }
             }
-            if(!visited[vb]){
-                visited[vb] = true;
-                vertQ.push(vb);
+
+            remaining[v]--;
+        }
+
+        // move the vertices of the triangle to the front of the cache
+        nextCache.clear();
+        for(int c = 0; c < 3; c++){
+            if(find(nextCache.begin(), nextCache.end(), corners[c]) == nextCache.end())
+                nextCache.push_back(corners[c]);
+        }
+        for(auto it = cache.begin(); it != cache.end(); ++it){
+            if(*it != corners[0] && *it != corners[1] && *it != corners[2])
+                nextCache.push_back(*it);
+        }
+
+        // update the scores of the vertices whose position changed and of
+        // their triangles, the best one is the next triangle
+        float bestScore = 0.f;
+        bool found = false;
+
+        for(unsigned int n = 0; n < nextCache.size(); n++){
+            unsigned int v = nextCache[n];
+            cachePosition[v] = n < cacheSize ? (int)n : -1;
+            vertexScore[v] = vertexCacheScore(cachePosition[v], remaining[v], cacheSize);
+        }
+
+        for(unsigned int n = 0; n < nextCache.size(); n++){
+            unsigned int v = nextCache[n];
+
+            for(unsigned int e = offsets[v]; e < offsets[v] + remaining[v]; e++){
+                unsigned int t = adjacency[e];
+                triangleScore[t] = vertexScore[triangles[t].a] + vertexScore[triangles[t].b] + vertexScore[triangles[t].c];
+
+                if(!found || triangleScore[t] > bestScore){
+                    best = t;
+                    bestScore = triangleScore[t];
+                    found = true;
+                }
+            }
+        }
+
+        if(nextCache.size() > cacheSize)
+            nextCache.resize(cacheSize);
+        swap(cache, nextCache);
+
+        if(ordered.size() == triangleCount)
+            break;
+
+        // dead end : no cached vertex has triangles left, continue with
+        // the next triangle in the original order
+        if(!found){
+            while(emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+    }
+
+    triangles.swap(ordered);
+
+    if(!sharedOffsets.empty())
+        assignSharedTriangles();
+}
+
+void Mesh::optimizeVertexFetch()
+{
+    TRACE_ZONE("Mesh::optimizeVertexFetch");
+
+    // renumber the vertices in the order they are first used by the
+    // triangles so they are fetched sequentially, unused vertices are removed
+
+    const unsigned int UNUSED = 0xFFFFFFFF;
+
+    vector<unsigned int> remap(vertices.size(), UNUSED);
+    vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        unsigned int *corners[3] = { &it->a, &it->b, &it->c };
+
+        for(int c = 0; c < 3; c++){
+            unsigned int& v = *corners[c];
+
+            if(remap[v] == UNUSED){
+                remap[v] = ordered.size();
+                ordered.push_back(vertices[v]);
             }
-            if(!visited[vc]){
-                visited[vc] = true;
-                vertQ.push(vc);
+
+            v = remap[v];
+        }
+    }
+
+    vertices.swap(ordered);
+
+    if(!sharedOffsets.empty())
+        assignSharedTriangles();
+}
+
+Mesh::CacheStatistics Mesh::getCacheStatistics(unsigned int cacheSize) const
+{
+    // simulate a FIFO post-transform cache, as found in most GPUs, and
+    // count the vertices transformed again after being evicted
+
+    CacheStatistics statistics = { 0.f, 0.f };
+
+    if(triangles.empty() || cacheSize == 0)
+        return statistics;
+
+    // insertion time of each vertex in the cache, a vertex is cached until
+    // cacheSize other vertices are inserted after it
+    vector<unsigned int> insertion(vertices.size(), 0);
+    vector<bool> used(vertices.size(), false);
+    unsigned int transformed = 0;
+    unsigned int usedCount = 0;
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        const unsigned int corners[3] = { it->a, it->b, it->c };
+
+        for(int c = 0; c < 3; c++){
+            unsigned int v = corners[c];
+
+            if(!used[v]){
+                used[v] = true;
+                usedCount++;
+            } else if(transformed - insertion[v] <= cacheSize){
+                continue;
             }
+
+            insertion[v] = transformed++;
         }
     }
+
+    statistics.acmr = (float)transformed / triangles.size();
+    statistics.atvr = (float)transformed / usedCount;
+
+    return statistics;
+}
+
+size_t Mesh::memorySize() const
+{
+    return vertices.capacity() * sizeof(Vertex) + triangles.capacity() * sizeof(Triangle)
+         + (sharedOffsets.capacity() + sharedTriangles.capacity()) * sizeof(unsigned int);
 }
 
 float* Mesh::getVertexArray()
@@ -212,6 +548,268 @@ float* Mesh::getVertexArray()
     return vertexData;
 }
 
+size_t Mesh::getPackedVertexSize(const VertexFormat& format) const
+{
+    return vertices.size() * format.stride();
+}
+
+// octahedral encoding : the unit normal is projected on the octahedron
+// |x| + |y| + |z| = 1, whose lower half is folded over the upper one,
+// giving two coordinates in [-1, 1]
+static void encodeOctahedral(const vec3d& n, float& u, float& v)
+{
+    float length = fabs(n.x) + fabs(n.y) + fabs(n.z);
+
+    // degenerate normals may be null
+    if(!(length > 0.f)){
+        u = v = 0.f;
+        return;
+    }
+
+    u = n.x / length;
+    v = n.y / length;
+
+    if(n.z < 0.f){
+        float foldedU = (1.f - fabs(v)) * (u >= 0.f ? 1.f : -1.f);
+        float foldedV = (1.f - fabs(u)) * (v >= 0.f ? 1.f : -1.f);
+        u = foldedU;
+        v = foldedV;
+    }
+}
+
+// value in [-1, 1] to a signed normalized integer of the given maximum
+static int toSNorm(float value, int maximum)
+{
+    value = value < -1.f ? -1.f : value > 1.f ? 1.f : value;
+    return (int)lround(value * maximum);
+}
+
+// coordinate in [-size/2, size/2] to an unsigned normalized 16 bit integer
+static uint16_t toUNorm16(float value, float size)
+{
+    float t = size > 0.f ? value / size + 0.5f : 0.5f;
+    t = t < 0.f ? 0.f : t > 1.f ? 1.f : t;
+    return (uint16_t)lround(t * 65535.f);
+}
+
+void Mesh::packVertices(const VertexFormat& format, void *buffer) const
+{
+    TRACE_ZONE("Mesh::packVertices");
+
+    unsigned char *output = static_cast<unsigned char*>(buffer);
+
+    for(auto it = vertices.begin(); it != vertices.end(); ++it, output += format.stride()){
+        packVertex(format, *it, output);
+    }
+}
+
+void Mesh::packVertices(const VertexFormat& format, void *buffer, const vector<unsigned int>& vertexIds) const
+{
+    TRACE_ZONE("Mesh::packVertices");
+
+    unsigned char *output = static_cast<unsigned char*>(buffer);
+
+    for(auto it = vertexIds.begin(); it != vertexIds.end(); ++it, output += format.stride()){
+        packVertex(format, vertices[*it], output);
+    }
+}
+
+void Mesh::packVertex(const VertexFormat& format, const Vertex& vertex, unsigned char *output) const
+{
+    const vec3d& pos = vertex.pos;
+    const vec3d& normal = vertex.normal;
+    size_t normalOffset = format.normalOffset();
+
+    if(format.position == VertexFormat::PositionFloat32){
+        float values[3] = { pos.x, pos.y, pos.z };
+        memcpy(output, values, sizeof(values));
+    } else {
+        uint16_t values[3] = { toUNorm16(pos.x, dimX), toUNorm16(pos.y, dimY), toUNorm16(pos.z, dimZ) };
+        memcpy(output, values, sizeof(values));
+    }
+
+    // padding between the position and an aligned normal
+    size_t positionSize = format.positionSize();
+    if(positionSize < normalOffset)
+        memset(output + positionSize, 0, normalOffset - positionSize);
+
+    float u, v;
+
+    switch(format.normal){
+        case VertexFormat::NormalFloat32: {
+            float values[3] = { normal.x, normal.y, normal.z };
+            memcpy(output + normalOffset, values, sizeof(values));
+            break;
+        }
+        case VertexFormat::NormalOct16: {
+            encodeOctahedral(normal, u, v);
+            int16_t values[2] = { (int16_t)toSNorm(u, 32767), (int16_t)toSNorm(v, 32767) };
+            memcpy(output + normalOffset, values, sizeof(values));
+            break;
+        }
+        case VertexFormat::NormalOct8: {
+            encodeOctahedral(normal, u, v);
+            int8_t values[2] = { (int8_t)toSNorm(u, 127), (int8_t)toSNorm(v, 127) };
+            memcpy(output + normalOffset, values, sizeof(values));
+            break;
+        }
+        case VertexFormat::NormalNone:
+            break;
+    }
+
+    // zero the padding so the buffer content is deterministic
+    size_t used = normalOffset + format.normalSize();
+    if(used < format.stride())
+        memset(output + used, 0, format.stride() - used);
+}
+
+bool Mesh::writeObj(const string& path) const
+{
+    ofstream file(path);
+    if(!file)
+        return false;
+
+    file << "# " << vertices.size() << " vertices, " << triangles.size() << " triangles\n";
+    file << setprecision(7);
+
+    for(auto it = vertices.begin(); it != vertices.end(); ++it){
+        file << "v " << it->pos.x << " " << it->pos.y << " " << it->pos.z << "\n";
+    }
+    for(auto it = vertices.begin(); it != vertices.end(); ++it){
+        file << "vn " << it->normal.x << " " << it->normal.y << " " << it->normal.z << "\n";
+    }
+
+    // OBJ indices start at 1
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        file << "f " << it->a + 1 << "//" << it->a + 1;
+        file << " " << it->b + 1 << "//" << it->b + 1;
+        file << " " << it->c + 1 << "//" << it->c + 1 << "\n";
+    }
+
+    return (bool)file;
+}
+
+bool Mesh::writePly(const string& path) const
+{
+    ofstream file(path, ios::binary);
+    if(!file)
+        return false;
+
+    file << "ply\n";
+    file << "format binary_little_endian 1.0\n";
+    file << "element vertex " << vertices.size() << "\n";
+    file << "property float x\nproperty float y\nproperty float z\n";
+    file << "property float nx\nproperty float ny\nproperty float nz\n";
+    file << "element face " << triangles.size() << "\n";
+    file << "property list uchar uint vertex_indices\n";
+    file << "end_header\n";
+
+    // the data is written in the host byte order, little endian on the
+    // supported platforms
+    vector<float> vertexData(vertices.size() * 6);
+    float *v = vertexData.data();
+
+    for(auto it = vertices.begin(); it != vertices.end(); ++it, v += 6){
+        v[0] = it->pos.x;
+        v[1] = it->pos.y;
+        v[2] = it->pos.z;
+        v[3] = it->normal.x;
+        v[4] = it->normal.y;
+        v[5] = it->normal.z;
+    }
+
+    file.write((const char*)vertexData.data(), vertexData.size() * sizeof(float));
+
+    // each face is its vertex count followed by its 3 indices
+    const size_t faceSize = 1 + 3 * sizeof(uint32_t);
+    vector<char> faceData(triangles.size() * faceSize);
+    char *f = faceData.data();
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it, f += faceSize){
+        uint32_t indices[3] = { it->a, it->b, it->c };
+        f[0] = 3;
+        memcpy(f + 1, indices, sizeof(indices));
+    }
+
+    file.write(faceData.data(), faceData.size());
+
+    return (bool)file;
+}
+
+void Mesh::splitChunks(unsigned int maxVertices, unsigned int maxTriangles, vector<Chunk>& chunks, vector<unsigned int>& chunkVertices, vector<uint16_t>& indices) const
+{
+    TRACE_ZONE("Mesh::splitChunks");
+
+    // greedily add the triangles, in order, to the current chunk and start a
+    // new one when a triangle would exceed one of the limits
+
+    chunks.clear();
+    chunkVertices.clear();
+    indices.clear();
+    indices.reserve(triangles.size() * 3);
+
+    if(maxVertices > 65536)
+        maxVertices = 65536;
+    if(maxVertices < 3 || maxTriangles < 1 || triangles.empty())
+        return;
+
+    // local index of each vertex in the current chunk, valid when
+    // its stamp is the current chunk number
+    vector<uint16_t> localIndex(vertices.size());
+    vector<unsigned int> stamp(vertices.size(), 0);
+
+    Chunk chunk;
+    unsigned int chunkNumber = 0;
+    bool open = false;
+
+    for(auto it = triangles.begin(); it != triangles.end(); ++it){
+        const unsigned int corners[3] = { it->a, it->b, it->c };
+
+        unsigned int newVertices = 0;
+        if(open){
+            for(int c = 0; c < 3; c++){
+                if(stamp[corners[c]] != chunkNumber
+                   && (c < 1 || corners[c] != corners[0]) && (c < 2 || corners[c] != corners[1]))
+                    newVertices++;
+            }
+        }
+
+        if(!open || chunk.vertexCount + newVertices > maxVertices || chunk.indexCount / 3 + 1 > maxTriangles){
+            if(open)
+                chunks.push_back(chunk);
+
+            chunkNumber++;
+            chunk.firstVertex = chunkVertices.size();
+            chunk.vertexCount = 0;
+            chunk.firstIndex = indices.size();
+            chunk.indexCount = 0;
+            chunk.boundsMin = vertices[corners[0]].pos;
+            chunk.boundsMax = vertices[corners[0]].pos;
+            open = true;
+        }
+
+        for(int c = 0; c < 3; c++){
+            unsigned int v = corners[c];
+
+            if(stamp[v] != chunkNumber){
+                stamp[v] = chunkNumber;
+                localIndex[v] = (uint16_t)chunk.vertexCount++;
+                chunkVertices.push_back(v);
+
+                const vec3d& pos = vertices[v].pos;
+                chunk.boundsMin = vec3d(min(chunk.boundsMin.x, pos.x), min(chunk.boundsMin.y, pos.y), min(chunk.boundsMin.z, pos.z));
+                chunk.boundsMax = vec3d(max(chunk.boundsMax.x, pos.x), max(chunk.boundsMax.y, pos.y), max(chunk.boundsMax.z, pos.z));
+            }
+
+            indices.push_back(localIndex[v]);
+        }
+
+        chunk.indexCount += 3;
+    }
+
+    chunks.push_back(chunk);
+}
+
 unsigned int* Mesh::getTriangleArray()
 {
     // generate the indices array to load in the IBO
@@ -0,0 +1,174 @@
+#include "NodeField.h"
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <math.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+
+NodeField::NodeField()
+{
+
+}
+
+NodeField::NodeField(int _width, int _height, int _depth, float _nodeSize) : width(_width), height(_height), depth(_depth), nodeSize(_nodeSize)
+{
+    size_t nodeCount = (size_t)width * height * depth;
+
+    values.resize(nodeCount);
+    activeBits.resize((nodeCount + 63) / 64, 0);
+}
+
+// index of the lowest set bit of a non zero word
+static inline int lowestBit(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+void NodeField::setActive(size_t first, size_t last, bool active)
+{
+    while(first < last){
+        // bits [first, wordEnd) of the current word
+        size_t wordEnd = (first | 63) + 1;
+        size_t end = wordEnd < last ? wordEnd : last;
+
+        uint64_t mask = ~(uint64_t)0 << (first & 63);
+        if((end & 63) != 0)
+            mask &= ~(~(uint64_t)0 << (end & 63));
+
+        if(active)
+            activeBits[first >> 6] |= mask;
+        else
+            activeBits[first >> 6] &= ~mask;
+
+        first = end;
+    }
+}
+
+size_t NodeField::nextActive(size_t n, size_t end) const
+{
+    // scan whole words from n
+    while(n < end){
+        uint64_t word = activeBits[n >> 6] >> (n & 63);
+        if(word != 0){
+            n += lowestBit(word);
+            return n < end ? n : end;
+        }
+        n = (n | 63) + 1;
+    }
+    return end;
+}
+
+size_t NodeField::nextInactive(size_t n, size_t end) const
+{
+    while(n < end){
+        // the zeros shifted in are never taken for inactive nodes
+        uint64_t word = ~activeBits[n >> 6] >> (n & 63);
+        if(word != 0){
+            n += lowestBit(word);
+            return n < end ? n : end;
+        }
+        n = (n | 63) + 1;
+    }
+    return end;
+}
+
+vec3d NodeField::edgeVertex(int i, int j, int k, int axis, float surfaceLevel) const
+{
+    // x edges are interpolated from their end node to their start node,
+    // the other ones from their start node : this is the direction the
+    // mesher always used, changing it would move the vertices by an ulp
+    int i2 = i, j2 = j, k2 = k;
+
+    if(axis == 0){
+        i++;
+    } else if(axis == 1){
+        j2++;
+    } else {
+        k2++;
+    }
+
+    vec3d p1 = position(i, j, k);
+    vec3d p2 = position(i2, j2, k2);
+
+    float v1 = value(i, j, k);
+    float v2 = value(i2, j2, k2);
+
+    return p1 + (surfaceLevel - v1) * (p2 - p1) / (v2 - v1);
+}
+
+vec3d NodeField::gradient(const vec3d& pos) const
+{
+    // node coordinates of the position, inverse of position(i, j, k)
+    float coords[3] = {
+        (pos.x + width*nodeSize/2.f - nodeSize/2.f) / nodeSize,
+        (pos.y + height*nodeSize/2.f - nodeSize/2.f) / nodeSize,
+        (pos.z + depth*nodeSize/2.f - nodeSize/2.f) / nodeSize
+    };
+    int sizes[3] = { width, height, depth };
+
+    // the vertex lies on an edge : its coordinates are whole numbers but
+    // along the axis of the edge. Every cell sharing the edge then finds
+    // the same gradient, whatever the rounding of the position.
+    int axis = 0;
+    float farthest = -1.f;
+
+    for(int a = 0; a < 3; a++){
+        float distance = fabs(coords[a] - round(coords[a]));
+        if(distance > farthest){
+            farthest = distance;
+            axis = a;
+        }
+    }
+
+    int first[3];
+    for(int a = 0; a < 3; a++){
+        float c = min(max(coords[a], 0.f), (float)(sizes[a] - 1));
+        first[a] = a == axis ? min((int)c, max(sizes[a] - 2, 0)) : (int)round(c);
+    }
+
+    float t = min(max(coords[axis] - first[axis], 0.f), 1.f);
+
+    int second[3] = { first[0], first[1], first[2] };
+    second[axis] = min(first[axis] + 1, sizes[axis] - 1);
+
+    vec3d g1 = nodeGradient(first[0], first[1], first[2]);
+    vec3d g2 = nodeGradient(second[0], second[1], second[2]);
+
+    return g1 + t * (g2 - g1);
+}
+
+vec3d NodeField::nodeGradient(int i, int j, int k) const
+{
+    int coords[3] = { i, j, k };
+    int sizes[3] = { width, height, depth };
+    float g[3];
+
+    for(int axis = 0; axis < 3; axis++){
+        int lo[3] = { i, j, k };
+        int hi[3] = { i, j, k };
+        lo[axis] = max(coords[axis] - 1, 0);
+        hi[axis] = min(coords[axis] + 1, sizes[axis] - 1);
+
+        int span = hi[axis] - lo[axis];
+        g[axis] = span > 0 ? (value(hi[0], hi[1], hi[2]) - value(lo[0], lo[1], lo[2])) / span : 0.f;
+    }
+
+    return vec3d(g[0], g[1], g[2]);
+}
+
+NodeField::~NodeField()
+{
+
+}
@@ -0,0 +1,168 @@
+#include "ThreadPool.h"
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Trace.h>
+
+using namespace std;
+
+
+ThreadPool::ThreadPool(int threadCount) : queuedTasks(0), nextWorker(0)
+{
+    if(threadCount <= 0)
+        threadCount = thread::hardware_concurrency();
+    if(threadCount <= 0)
+        threadCount = 1;
+
+    for(int i = 0; i < threadCount; i++){
+        queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+
+    for(int i = 0; i < threadCount; i++){
+        workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+void ThreadPool::parallelFor(int taskCount, const function<void(int)>& task)
+{
+    if(taskCount <= 0)
+        return;
+
+    // completion state of this batch, every task decrements the counter
+    // under the lock so the batch can't be destroyed while being signaled
+    struct Batch
+    {
+        mutex lock;
+        condition_variable done;
+        int remaining;
+    } batch;
+
+    batch.remaining = taskCount;
+
+    int workerCount = getThreadCount();
+
+    for(int w = 0; w < workerCount; w++){
+        int first = (int)((long long)taskCount * w / workerCount);
+        int last = (int)((long long)taskCount * (w + 1) / workerCount);
+
+        for(int index = first; index < last; index++){
+            push(w, [&batch, &task, index](){
+                task(index);
+
+                lock_guard<mutex> guard(batch.lock);
+                if(--batch.remaining == 0)
+                    batch.done.notify_all();
+            });
+        }
+    }
+
+    // help the workers instead of sleeping while there is work queued
+    function<void()> stolen;
+
+    while(true){
+        {
+            lock_guard<mutex> guard(batch.lock);
+            if(batch.remaining == 0)
+                break;
+        }
+
+        if(takeTask(-1, stolen)){
+            stolen();
+        } else {
+            unique_lock<mutex> guard(batch.lock);
+            batch.done.wait(guard, [&batch](){ return batch.remaining == 0; });
+            break;
+        }
+    }
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+    // deal the tasks to the workers in turn, idle workers steal the others
+    int worker = (int)(nextWorker++ % (unsigned int)getThreadCount());
+    push(worker, move(task));
+}
+
+void ThreadPool::push(int worker, function<void()> task)
+{
+    {
+        lock_guard<mutex> guard(queues[worker]->lock);
+        queues[worker]->tasks.push_back(move(task));
+    }
+
+    queuedTasks++;
+
+    // take the wake lock so a worker between its check and its wait
+    // can't miss the notification
+    lock_guard<mutex> guard(wakeLock);
+    wakeCondition.notify_all();
+}
+
+bool ThreadPool::takeTask(int worker, function<void()>& task)
+{
+    int queueCount = (int)queues.size();
+
+    if(worker >= 0){
+        WorkQueue& own = *queues[worker];
+        lock_guard<mutex> guard(own.lock);
+        if(!own.tasks.empty()){
+            task = move(own.tasks.front());
+            own.tasks.pop_front();
+            queuedTasks--;
+            return true;
+        }
+    }
+
+    // steal from the other queues, starting with the next one
+    for(int offset = 1; offset <= queueCount; offset++){
+        int victim = ((worker < 0 ? 0 : worker) + offset) % queueCount;
+        if(victim == worker)
+            continue;
+
+        WorkQueue& queue = *queues[victim];
+        lock_guard<mutex> guard(queue.lock);
+        if(!queue.tasks.empty()){
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queuedTasks--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(int worker)
+{
+    TRACE_THREAD_NAME("worker");
+
+    function<void()> task;
+
+    while(true){
+        if(takeTask(worker, task)){
+            task();
+            continue;
+        }
+
+        unique_lock<mutex> guard(wakeLock);
+        wakeCondition.wait(guard, [this](){ return stopping || queuedTasks > 0; });
+        if(stopping && queuedTasks == 0)
+            return;
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> guard(wakeLock);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for(auto it = workers.begin(); it != workers.end(); ++it){
+        it->join();
+    }
+}
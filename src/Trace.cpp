@@ -0,0 +1,166 @@
+#include "Trace.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *name;
+        int64_t start;
+        int64_t end;
+    };
+
+    // ring buffer of the zones of one thread, only written by its thread.
+    // count is the number of zones ever recorded, the last CAPACITY are kept
+    struct ThreadBuffer
+    {
+        int id;
+        string name;
+        vector<TraceEvent> events;
+        atomic<size_t> count;
+
+        ThreadBuffer(int _id) : id(_id), events(Trace::CAPACITY), count(0) {}
+    };
+
+    // the buffers are kept after their thread exits so its zones can still be written
+    struct Registry
+    {
+        mutex lock;
+        vector<unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    const chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    ThreadBuffer& threadBuffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+
+        if(buffer == nullptr){
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            r.buffers.push_back(unique_ptr<ThreadBuffer>(new ThreadBuffer((int)r.buffers.size() + 1)));
+            buffer = r.buffers.back().get();
+        }
+
+        return *buffer;
+    }
+
+    // zone and thread names are written as JSON strings
+    void writeString(ostream& out, const string& text)
+    {
+        out << '"';
+        for(char c : text){
+            if(c == '"' || c == '\\')
+                out << '\\' << c;
+            else if((unsigned char)c < 0x20)
+                out << ' ';
+            else
+                out << c;
+        }
+        out << '"';
+    }
+}
+
+bool Trace::enabled()
+{
+#ifdef MC_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+int64_t Trace::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+void Trace::record(const char *name, int64_t start, int64_t end)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    size_t count = buffer.count.load(memory_order_relaxed);
+
+    buffer.events[count % CAPACITY] = { name, start, end };
+    buffer.count.store(count + 1, memory_order_release);
+}
+
+void Trace::setThreadName(const char *name)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    lock_guard<mutex> guard(registry().lock);
+    buffer.name = name;
+}
+
+bool Trace::writeChromeTrace(const string& path)
+{
+    ofstream file(path);
+    if(!file)
+        return false;
+
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+
+    // complete events ("X") with their times in microseconds, plus the
+    // thread names as metadata events
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    file << fixed << setprecision(3);
+
+    bool first = true;
+
+    for(auto it = r.buffers.begin(); it != r.buffers.end(); ++it){
+        const ThreadBuffer& buffer = **it;
+        size_t count = buffer.count.load(memory_order_acquire);
+        size_t kept = count < CAPACITY ? count : CAPACITY;
+
+        if(!buffer.name.empty()){
+            file << (first ? "\n" : ",\n");
+            file << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << buffer.id << ", \"args\": {\"name\": ";
+            writeString(file, buffer.name);
+            file << "}}";
+            first = false;
+        }
+
+        for(size_t n = count - kept; n < count; n++){
+            const TraceEvent& event = buffer.events[n % CAPACITY];
+
+            file << (first ? "\n" : ",\n");
+            file << "{\"ph\": \"X\", \"name\": ";
+            writeString(file, event.name);
+            file << ", \"pid\": 1, \"tid\": " << buffer.id;
+            file << ", \"ts\": " << event.start / 1000.;
+            file << ", \"dur\": " << (event.end - event.start) / 1000. << "}";
+            first = false;
+        }
+    }
+
+    file << "\n]}\n";
+
+    return (bool)file;
+}
+
+void Trace::clear()
+{
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+
+    for(auto it = r.buffers.begin(); it != r.buffers.end(); ++it){
+        (*it)->count.store(0, memory_order_release);
+    }
+}
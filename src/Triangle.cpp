@@ -1,5 +1,10 @@
 #include "Triangle.h"
 
+Triangle::Triangle() : a(0), b(0), c(0)
+{
+
+}
+
 Triangle::Triangle(unsigned int _a, unsigned int _b, unsigned int _c) : a(_a), b(_b), c(_c)
 {
 
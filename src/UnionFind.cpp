@@ -0,0 +1,24 @@
+#include "UnionFind.h"
+
+#include <vector>
+
+using namespace std;
+
+
+UnionFind::UnionFind()
+{
+
+}
+
+UnionFind::UnionFind(unsigned int size) : parent(size)
+{
+    // every element starts in its own set
+    for(unsigned int i = 0; i < size; i++){
+        parent[i] = i;
+    }
+}
+
+UnionFind::~UnionFind()
+{
+
+}
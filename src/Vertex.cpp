@@ -3,6 +3,11 @@
 #include <vec3d.h>
 
 
+Vertex::Vertex()
+{
+
+}
+
 Vertex::Vertex(vec3d _pos) : pos(_pos)
 {
 
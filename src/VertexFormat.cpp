@@ -0,0 +1,48 @@
+#include "VertexFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+VertexFormat::VertexFormat()
+{
+
+}
+
+VertexFormat::VertexFormat(PositionEncoding _position, NormalEncoding _normal) : position(_position), normal(_normal)
+{
+
+}
+
+size_t VertexFormat::positionSize() const
+{
+    return position == PositionFloat32 ? 3 * sizeof(float) : 3 * sizeof(uint16_t);
+}
+
+size_t VertexFormat::normalSize() const
+{
+    switch(normal){
+        case NormalFloat32: return 3 * sizeof(float);
+        case NormalOct16: return 2 * sizeof(int16_t);
+        case NormalOct8: return 2 * sizeof(int8_t);
+        default: return 0;
+    }
+}
+
+size_t VertexFormat::normalOffset() const
+{
+    // float normals are aligned on 4 bytes, the other encodings follow the position
+    if(normal == NormalFloat32)
+        return (positionSize() + 3) & ~(size_t)3;
+    return positionSize();
+}
+
+size_t VertexFormat::stride() const
+{
+    return (normalOffset() + normalSize() + 3) & ~(size_t)3;
+}
+
+VertexFormat::~VertexFormat()
+{
+
+}
@@ -42,7 +42,11 @@ float vec3d::length()
 
 void vec3d::normalize()
 {
+    // a null vector has no direction and is left null
     float len = length();
+    if(len <= 0.f)
+        return;
+
     x /= len;
     y /= len;
     z /= len;
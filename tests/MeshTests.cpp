@@ -0,0 +1,634 @@
+// Checks of the generator invariants : lookup tables, determinism across
+// thread counts, closed and filtered surfaces, mesh reordering, chunking,
+// vertex packing, memory accounting, terrain streaming and field editing.
+// Returns a non zero exit code when a check fails.
+//
+// usage : MeshTests
+
+#include <MapGenerator.h>
+#include <ChunkManager.h>
+#include <FieldEditor.h>
+#include <Mesh.h>
+#include <Table.h>
+#include <UnionFind.h>
+#include <VertexFormat.h>
+#include <MemoryTracker.h>
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <cstdint>
+#include <new>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)){ \
+            cerr << __FILE__ << ":" << __LINE__ << ": check failed : " #condition << endl; \
+            failures++; \
+        } \
+    } while(0)
+
+// generate a small map with the default parameters
+static void generate(MapGenerator& generator, int seed, int size, bool optimize)
+{
+    generator.gridWidth = generator.gridHeight = generator.gridDepth = size;
+    generator.optimizeMesh = optimize;
+    generator.generate(seed);
+}
+
+// triangles as position triples rotated to start with their smallest
+// corner, so they can be compared across vertex and triangle orders
+// without losing the winding
+static multiset<vector<float>> triangleSet(const Mesh& mesh)
+{
+    multiset<vector<float>> triangles;
+
+    for(auto it = mesh.triangles.begin(); it != mesh.triangles.end(); ++it){
+        const vec3d corners[3] = { mesh.vertices[it->a].pos, mesh.vertices[it->b].pos, mesh.vertices[it->c].pos };
+        vector<float> best;
+
+        for(int r = 0; r < 3; r++){
+            vector<float> rotated;
+            for(int c = 0; c < 3; c++){
+                const vec3d& p = corners[(r + c) % 3];
+                rotated.insert(rotated.end(), { p.x, p.y, p.z });
+            }
+            if(r == 0 || rotated < best)
+                best = rotated;
+        }
+
+        triangles.insert(best);
+    }
+
+    return triangles;
+}
+
+static void testTables()
+{
+    // the flattened triangle list matches the original table
+    unsigned int total = 0;
+
+    for(int configuration = 0; configuration < 256; configuration++){
+        int count = 0;
+        uint16_t edges = 0;
+
+        while(triTable[configuration][count*3] != -1){
+            for(int c = 0; c < 3; c++){
+                int edge = triTable[configuration][count*3 + c];
+                CHECK(triangleList[triangleOffsets[configuration] + count*3 + c] == edge);
+                edges |= 1 << edge;
+            }
+            count++;
+        }
+
+        CHECK(triangleCounts[configuration] == count);
+        CHECK(triangleOffsets[configuration] == total);
+        CHECK(edgeTable[configuration] == edges);
+        total += count * 3;
+    }
+
+    CHECK(triangleOffsets[256] == total);
+}
+
+static void testDeterminism()
+{
+    // the parallel steps give the same mesh whatever the thread count
+    MapGenerator single(1);
+    MapGenerator multiple(3);
+
+    for(int seed : { 1, 42 }){
+        generate(single, seed, 40, false);
+        generate(multiple, seed, 40, false);
+
+        const Mesh& a = single.mesh;
+        const Mesh& b = multiple.mesh;
+
+        CHECK(a.vertices.size() == b.vertices.size());
+        CHECK(a.triangles.size() == b.triangles.size());
+        CHECK(!a.triangles.empty());
+
+        bool same = a.vertices.size() == b.vertices.size() && a.triangles.size() == b.triangles.size();
+
+        // compared bitwise, every vertex is used and has a unit normal
+        bool unit = true;
+        for(size_t v = 0; v < a.vertices.size(); v++){
+            vec3d normal = a.vertices[v].normal;
+            unit = unit && fabs(normal.length() - 1.f) < 1e-4f;
+        }
+        CHECK(unit);
+
+        for(size_t v = 0; same && v < a.vertices.size(); v++){
+            const vec3d *x[2] = { &a.vertices[v].pos, &a.vertices[v].normal };
+            const vec3d *y[2] = { &b.vertices[v].pos, &b.vertices[v].normal };
+            for(int n = 0; n < 2; n++){
+                const float xs[3] = { x[n]->x, x[n]->y, x[n]->z };
+                const float ys[3] = { y[n]->x, y[n]->y, y[n]->z };
+                same = same && memcmp(xs, ys, sizeof(xs)) == 0;
+            }
+        }
+        for(size_t t = 0; same && t < a.triangles.size(); t++){
+            const Triangle& x = a.triangles[t];
+            const Triangle& y = b.triangles[t];
+            same = x.a == y.a && x.b == y.b && x.c == y.c;
+        }
+
+        CHECK(same);
+    }
+
+    // an empty grid gives an empty mesh, whatever the marching
+    CellGrid empty;
+    CubeGrid emptyGrid;
+    emptyGrid.generateGrid(empty, 0.1f, 0.5f, 0);
+
+    ThreadPool pool(2);
+    Mesh serial, inPlace, parallel;
+    serial.generateMesh(emptyGrid, 0);
+    inPlace.generateMesh(emptyGrid, 0, true);
+    parallel.generateMesh(emptyGrid, 0, pool);
+    CHECK(serial.vertices.empty() && inPlace.vertices.empty() && parallel.vertices.empty());
+    CHECK(serial.triangles.empty() && inPlace.triangles.empty() && parallel.triangles.empty());
+}
+
+static void testClosedFilteredSurface()
+{
+    // the borders of the field are pushed below the surface level so the
+    // surface is closed : every edge is shared by exactly two triangles,
+    // once in each direction, and every kept region is big enough
+    MapGenerator generator(2);
+    generate(generator, 1337, 50, true);
+
+    const Mesh& mesh = generator.mesh;
+    map<pair<unsigned int, unsigned int>, int> edges;
+
+    for(auto it = mesh.triangles.begin(); it != mesh.triangles.end(); ++it){
+        const unsigned int corners[3] = { it->a, it->b, it->c };
+        for(int c = 0; c < 3; c++){
+            edges[make_pair(corners[c], corners[(c + 1) % 3])]++;
+        }
+    }
+
+    bool closed = true;
+    for(auto it = edges.begin(); it != edges.end(); ++it){
+        auto reverse = edges.find(make_pair(it->first.second, it->first.first));
+        closed = closed && it->second == 1 && reverse != edges.end() && reverse->second == 1;
+    }
+    CHECK(closed);
+
+    UnionFind regions(mesh.vertices.size());
+    for(auto it = mesh.triangles.begin(); it != mesh.triangles.end(); ++it){
+        regions.unite(it->a, it->b);
+        regions.unite(it->a, it->c);
+    }
+
+    map<unsigned int, unsigned int> regionTriangles;
+    for(auto it = mesh.triangles.begin(); it != mesh.triangles.end(); ++it){
+        regionTriangles[regions.find(it->a)]++;
+    }
+    for(auto it = regionTriangles.begin(); it != regionTriangles.end(); ++it){
+        CHECK(it->second >= generator.minRegionSize);
+    }
+
+    // the normals are unit vectors
+    bool normalized = true;
+    for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it){
+        vec3d normal = it->normal;
+        normalized = normalized && fabs(normal.length() - 1.f) < 1e-4f;
+    }
+    CHECK(normalized);
+}
+
+static void testOptimization()
+{
+    // the reordering keeps the same triangles and improves the cache use
+    MapGenerator generator(1);
+    generate(generator, 42, 50, false);
+
+    Mesh mesh = generator.mesh;
+    multiset<vector<float>> before = triangleSet(mesh);
+    Mesh::CacheStatistics statistics = mesh.getCacheStatistics();
+
+    mesh.optimizeVertexCache();
+    mesh.optimizeVertexFetch();
+
+    Mesh::CacheStatistics optimized = mesh.getCacheStatistics();
+
+    CHECK(triangleSet(mesh) == before);
+    CHECK(optimized.acmr < statistics.acmr);
+    CHECK(optimized.atvr >= 1.f);
+
+    // vertices are numbered in their first use order
+    unsigned int next = 0;
+    bool ordered = true;
+    for(auto it = mesh.triangles.begin(); it != mesh.triangles.end(); ++it){
+        const unsigned int corners[3] = { it->a, it->b, it->c };
+        for(int c = 0; c < 3; c++){
+            ordered = ordered && corners[c] <= next;
+            if(corners[c] == next)
+                next++;
+        }
+    }
+    CHECK(ordered);
+    CHECK(next == mesh.vertices.size());
+
+    // a strip reuses the 2 previous vertices of each triangle : a cache of 2
+    // vertices transforms each vertex once, a cache of 1 vertex every corner
+    Mesh strip;
+    for(unsigned int v = 0; v < 12; v++){
+        strip.vertices.push_back(Vertex(vec3d((float)v, (float)(v % 2), 0.f)));
+    }
+    for(unsigned int t = 0; t < 10; t++){
+        strip.triangles.push_back(Triangle(t, t + 1, t + 2));
+    }
+
+    CHECK(fabs(strip.getCacheStatistics(2).acmr - 12.f / 10.f) < 1e-6f);
+    CHECK(fabs(strip.getCacheStatistics(2).atvr - 1.f) < 1e-6f);
+    CHECK(fabs(strip.getCacheStatistics(1).acmr - 3.f) < 1e-6f);
+}
+
+static void testChunks()
+{
+    // the chunk indices give back the mesh triangles, within the limits
+    MapGenerator generator(1);
+    generate(generator, 1, 50, true);
+
+    const Mesh& mesh = generator.mesh;
+    const unsigned int limits[][2] = { { 65535, 0xFFFFFFFF }, { Mesh::MESHLET_VERTICES, Mesh::MESHLET_TRIANGLES } };
+
+    for(auto& limit : limits){
+        vector<Mesh::Chunk> chunks;
+        vector<unsigned int> chunkVertices;
+        vector<uint16_t> indices;
+
+        mesh.splitChunks(limit[0], limit[1], chunks, chunkVertices, indices);
+
+        CHECK(indices.size() == mesh.triangles.size() * 3);
+
+        size_t t = 0;
+        bool valid = true;
+
+        for(auto it = chunks.begin(); it != chunks.end(); ++it){
+            valid = valid && it->vertexCount <= limit[0] && it->indexCount / 3 <= limit[1];
+
+            for(unsigned int i = 0; i < it->indexCount; i += 3, t++){
+                const Triangle& triangle = mesh.triangles[t];
+                const unsigned int corners[3] = { triangle.a, triangle.b, triangle.c };
+
+                for(int c = 0; c < 3; c++){
+                    unsigned int local = indices[it->firstIndex + i + c];
+                    valid = valid && local < it->vertexCount;
+                    valid = valid && chunkVertices[it->firstVertex + local] == corners[c];
+                }
+            }
+        }
+
+        CHECK(valid);
+        CHECK(t == mesh.triangles.size());
+    }
+}
+
+static void testPacking()
+{
+    // quantized positions and octahedral normals decode close to the originals
+    MapGenerator generator(1);
+    generate(generator, 7, 40, false);
+
+    const Mesh& mesh = generator.mesh;
+    VertexFormat format(VertexFormat::PositionUNorm16, VertexFormat::NormalOct16);
+
+    CHECK(format.stride() == 12);
+    CHECK(mesh.getPackedVertexSize(format) == mesh.vertices.size() * 12);
+
+    // float normals are aligned on 4 bytes after 16 bit positions
+    VertexFormat aligned(VertexFormat::PositionUNorm16, VertexFormat::NormalFloat32);
+    CHECK(aligned.normalOffset() == 8 && aligned.stride() == 20);
+
+    vector<unsigned char> buffer(mesh.getPackedVertexSize(format));
+    mesh.packVertices(format, buffer.data());
+
+    const float dimensions[3] = { mesh.dimX, mesh.dimY, mesh.dimZ };
+    float positionError = 0.f;
+    float normalError = 0.f;
+
+    for(size_t v = 0; v < mesh.vertices.size(); v++){
+        const unsigned char *vertex = &buffer[v * format.stride()];
+        uint16_t position[3];
+        int16_t normal[2];
+
+        memcpy(position, vertex, sizeof(position));
+        memcpy(normal, vertex + format.normalOffset(), sizeof(normal));
+
+        const vec3d& original = mesh.vertices[v].pos;
+        const float coordinates[3] = { original.x, original.y, original.z };
+
+        for(int a = 0; a < 3; a++){
+            float decoded = (position[a] / 65535.f - 0.5f) * dimensions[a];
+            positionError = max(positionError, fabsf(decoded - coordinates[a]));
+        }
+
+        float x = max(normal[0] / 32767.f, -1.f);
+        float y = max(normal[1] / 32767.f, -1.f);
+        float z = 1.f - fabsf(x) - fabsf(y);
+
+        if(z < 0.f){
+            float foldedX = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+            float foldedY = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+            x = foldedX;
+            y = foldedY;
+        }
+
+        vec3d decoded(x, y, z);
+        decoded.normalize();
+        normalError = max(normalError, vec3d::distance(decoded, mesh.vertices[v].normal));
+    }
+
+    CHECK(positionError <= max(dimensions[0], max(dimensions[1], dimensions[2])) / 65535.f);
+    CHECK(normalError < 1e-3f);
+}
+
+static void testMemory()
+{
+    // clearing the cube grid releases its nodes
+    CellGrid cellGrid(32, 32, 32);
+    FastNoise noise;
+    cellGrid.fillGrid(noise, 3, 2.f, 0.5f, 3.f);
+
+    CubeGrid cubeGrid;
+    cubeGrid.generateGrid(cellGrid, 0.1f, 0.5f, 100);
+    CHECK(cubeGrid.nodes.memorySize() >= cellGrid.size() * sizeof(float));
+
+    cubeGrid.clear();
+    CHECK(cubeGrid.nodes.memorySize() == 0);
+
+    // the step measures are consistent when the allocations are counted
+    MapGenerator generator(1);
+    generate(generator, 3, 40, true);
+
+    const MemoryTracker::Usage steps[] = { generator.memory.fillGrid, generator.memory.generateGrid,
+                                           generator.memory.generateMesh, generator.memory.optimizeMesh };
+
+    for(const MemoryTracker::Usage& usage : steps){
+        if(MemoryTracker::enabled()){
+            CHECK(usage.allocationCount > 0);
+            CHECK(usage.retainedBytes <= (long long)usage.allocatedBytes);
+            CHECK(usage.peakBytes >= (size_t)max(usage.retainedBytes, 0LL));
+        } else {
+            CHECK(usage.allocatedBytes == 0 && usage.allocationCount == 0);
+        }
+    }
+
+    CHECK(generator.memory.meshBytes >= generator.mesh.vertices.size() * sizeof(Vertex));
+
+    // a size leaving no room for the block header fails instead of wrapping
+    if(MemoryTracker::enabled()){
+        volatile size_t hugeSize = SIZE_MAX - 8;
+        bool thrown = false;
+        try {
+            ::operator delete(::operator new(hugeSize));
+        } catch(const bad_alloc&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+}
+
+static void testStreaming()
+{
+    // two neighbour chunks find the same vertices and normals on their shared face
+    ChunkManager::Settings settings;
+    settings.chunkSize = 16;
+    settings.optimizeMesh = false;
+
+    FastNoise noise(7);
+    noise.SetNoiseType(FastNoise::Simplex);
+
+    ChunkManager::Chunk left, right;
+    left.coord = Coord(0, 0, 0);
+    right.coord = Coord(1, 0, 0);
+    ChunkManager::generateChunk(left, settings, noise);
+    ChunkManager::generateChunk(right, settings, noise);
+
+    float half = settings.chunkSize * settings.cubeSize / 2.f;
+    float tolerance = 1e-4f;
+
+    auto faceVertices = [&](const ChunkManager::Chunk& chunk, float x){
+        vector<Vertex> face;
+        for(auto it = chunk.mesh.vertices.begin(); it != chunk.mesh.vertices.end(); ++it){
+            if(fabs(it->pos.x - x) < tolerance){
+                face.push_back(*it);
+                face.back().pos = chunk.center + it->pos;
+            }
+        }
+        sort(face.begin(), face.end(), [](const Vertex& a, const Vertex& b){
+            return make_tuple(a.pos.y, a.pos.z) < make_tuple(b.pos.y, b.pos.z);
+        });
+        return face;
+    };
+
+    vector<Vertex> leftFace = faceVertices(left, half);
+    vector<Vertex> rightFace = faceVertices(right, -half);
+
+    CHECK(!leftFace.empty());
+    CHECK(leftFace.size() == rightFace.size());
+
+    bool seamless = leftFace.size() == rightFace.size();
+    bool smooth = seamless;
+    for(size_t n = 0; seamless && n < leftFace.size(); n++){
+        seamless = vec3d::distance(leftFace[n].pos, rightFace[n].pos) < tolerance;
+        smooth = smooth && vec3d::distance(leftFace[n].normal, rightFace[n].normal) < 1e-3f;
+    }
+    CHECK(seamless);
+    CHECK(smooth);
+
+    // the resident chunks stay bounded, the nearest ones being loaded first
+    ChunkManager manager(2);
+    manager.settings.chunkSize = 8;
+    manager.viewDistance = 1;
+    manager.maxResidentChunks = 5;
+
+    vector<Coord> loaded;
+    auto start = chrono::steady_clock::now();
+
+    while(manager.getResidentCount() < manager.maxResidentChunks && chrono::steady_clock::now() - start < chrono::seconds(30)){
+        manager.update(vec3d());
+        vector<Coord> chunks = manager.takeLoadedChunks();
+        loaded.insert(loaded.end(), chunks.begin(), chunks.end());
+        CHECK(manager.getResidentCount() + manager.getPendingCount() <= manager.maxResidentChunks);
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    CHECK(manager.getResidentCount() == manager.maxResidentChunks);
+    CHECK(loaded.size() == manager.maxResidentChunks);
+    CHECK(manager.getChunk(Coord(0, 0, 0)) != nullptr);
+
+    // moving far away evicts all of them
+    manager.update(vec3d(100.f, 0.f, 0.f));
+    CHECK(manager.getResidentCount() == 0);
+    CHECK(manager.takeEvictedChunks().size() == loaded.size());
+}
+
+// mesh made of the non degenerate triangles of the editor buffers
+static Mesh editorMesh(const FieldEditor& editor)
+{
+    // the spare room of the slots holds unused vertices, they are left out
+    Mesh mesh;
+    size_t stride = editor.format.stride();
+    vector<unsigned int> remap(editor.getVertexCount(), 0xFFFFFFFF);
+
+    auto vertex = [&](uint32_t v){
+        if(remap[v] == 0xFFFFFFFF){
+            float position[3], normal[3];
+            memcpy(position, &editor.vertexData[v * stride], sizeof(position));
+            memcpy(normal, &editor.vertexData[v * stride + editor.format.normalOffset()], sizeof(normal));
+            remap[v] = mesh.vertices.size();
+            mesh.vertices.push_back(Vertex(vec3d(position[0], position[1], position[2])));
+            mesh.vertices.back().normal = vec3d(normal[0], normal[1], normal[2]);
+        }
+        return remap[v];
+    };
+
+    for(size_t n = 0; n < editor.indices.size(); n += 3){
+        const uint32_t *t = &editor.indices[n];
+        if(t[0] != t[1] || t[1] != t[2])
+            mesh.triangles.push_back(Triangle(vertex(t[0]), vertex(t[1]), vertex(t[2])));
+    }
+
+    return mesh;
+}
+
+static void testEditing()
+{
+    CellGrid cellGrid(33, 33, 33);
+    FastNoise noise(5);
+    noise.SetNoiseType(FastNoise::Simplex);
+    cellGrid.fillGrid(noise, 3, 2.f, 0.5f, 3.f);
+
+    // normals of a mesh against the gradient of the whole field, the vertices
+    // on the faces of the bricks have the same normal in both bricks
+    auto gradientNormals = [](const Mesh& mesh, CellGrid& field){
+        CubeGrid grid;
+        grid.generateGrid(field, 0.1f, 0.5f, 0);
+
+        bool same = true;
+        for(auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it){
+            vec3d expected = -1.f * grid.nodes.gradient(it->pos);
+            expected.normalize();
+            same = same && vec3d::distance(it->normal, expected) < 1e-3f;
+        }
+        return same;
+    };
+
+    auto coincidentNormals = [](Mesh mesh){
+        sort(mesh.vertices.begin(), mesh.vertices.end(), [](const Vertex& a, const Vertex& b){
+            return make_tuple(a.pos.x, a.pos.y, a.pos.z) < make_tuple(b.pos.x, b.pos.y, b.pos.z);
+        });
+
+        size_t pairs = 0;
+        bool same = true;
+        for(size_t v = 1; v < mesh.vertices.size(); v++){
+            const Vertex& a = mesh.vertices[v - 1];
+            const Vertex& b = mesh.vertices[v];
+            if(vec3d::distance(a.pos, b.pos) < 1e-5f){
+                pairs++;
+                same = same && vec3d::distance(a.normal, b.normal) < 1e-3f;
+            }
+        }
+        return pairs > 0 && same;
+    };
+
+    // the bricks together give the triangles of the whole grid
+    FieldEditor editor(VertexFormat::NormalFloat32, 2);
+    editor.build(cellGrid, 0.1f, 0.5f);
+    CHECK(editor.update() == 4*4*4);
+    CHECK(editor.buffersResized);
+
+    CubeGrid cubeGrid;
+    cubeGrid.generateGrid(cellGrid, 0.1f, 0.5f, 0);
+    Mesh whole;
+    whole.generateMesh(cubeGrid, 0, true);
+    CHECK(editorMesh(editor).triangles.size() == whole.triangles.size());
+    CHECK(gradientNormals(editorMesh(editor), editor.field));
+    CHECK(coincidentNormals(editorMesh(editor)));
+
+    // a small edit only remeshes the bricks around it, and after any edits
+    // the buffers hold the same triangles as a new build of the edited field
+    editor.clearChanges();
+    editor.addSphere(vec3d(-0.4f, -0.4f, -0.4f), 0.2f, 1.f);
+    CHECK(editor.getDirtyBrickCount() == 1);
+    CHECK(editor.update() == 1);
+    CHECK(editor.buffersResized || (editor.changedIndices.size() == 1 && editor.changedIndices[0].count < editor.indices.size()));
+
+    editor.subtractSphere(vec3d(0.3f, 0.f, 0.1f), 0.5f, 2.f);
+    editor.addBox(vec3d(-1.f, 0.5f, -1.f), vec3d(1.f, 0.7f, 1.f), 1.f);
+    editor.smooth(vec3d(0.f, 0.f, 0.f), 1.f, 0.5f);
+    editor.update();
+
+    FieldEditor rebuilt(VertexFormat::NormalFloat32, 1);
+    rebuilt.build(editor.field, 0.1f, 0.5f);
+    rebuilt.update();
+    CHECK(triangleSet(editorMesh(editor)) == triangleSet(editorMesh(rebuilt)));
+    CHECK(gradientNormals(editorMesh(editor), editor.field));
+    CHECK(coincidentNormals(editorMesh(editor)));
+
+    // the bricks without triangles have no index slot : a surface in the
+    // last brick only is meshed and edited as any other
+    CellGrid corner(20, 20, 20);
+    for(int i = 0; i < 20; i++){
+        for(int j = 0; j < 20; j++){
+            for(int k = 0; k < 20; k++){
+                corner.at(i, j, k) = i >= 17 && j >= 17 && k >= 17 ? 1.f : 0.f;
+            }
+        }
+    }
+
+    FieldEditor cornerEditor(VertexFormat::NormalFloat32, 1);
+    cornerEditor.build(corner, 0.1f, 0.5f);
+    CHECK(cornerEditor.update() == 3*3*3);
+    CHECK(!editorMesh(cornerEditor).triangles.empty());
+
+    cornerEditor.subtractBox(vec3d(-1.f, -1.f, -1.f), vec3d(1.f, 1.f, 1.f), 1.f);
+    cornerEditor.update();
+    CHECK(editorMesh(cornerEditor).triangles.empty());
+}
+
+int main()
+{
+    const pair<const char*, function<void()>> tests[] = {
+        { "tables", testTables },
+        { "determinism", testDeterminism },
+        { "closed filtered surface", testClosedFilteredSurface },
+        { "optimization", testOptimization },
+        { "chunks", testChunks },
+        { "packing", testPacking },
+        { "memory", testMemory },
+        { "streaming", testStreaming },
+        { "editing", testEditing },
+    };
+
+    for(auto& test : tests){
+        int previous = failures;
+        test.second();
+        cout << (failures == previous ? "[ ok ] " : "[fail] ") << test.first << endl;
+    }
+
+    if(failures > 0){
+        cout << failures << " checks failed" << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+// Generates a marching cubes mesh without any window or graphics library
+// and writes it to disk, along with the duration of each generation step.
+//
+// usage : MarchingCubesCli [options] output.obj|output.ply   (--help for the options)
+
+#include <MapGenerator.h>
+#include <Mesh.h>
+#include <Trace.h>
+#include <MemoryTracker.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+
+static void printUsage()
+{
+    cerr << "usage : MarchingCubesCli [options] output.obj|output.ply" << endl;
+    cerr << "  --size N | WxHxD    grid size in cells (default 50)" << endl;
+    cerr << "  --seed N            noise seed (default 1337)" << endl;
+    cerr << "  --octaves N         noise octaves (default 3)" << endl;
+    cerr << "  --lacunarity F      frequency factor between octaves (default 2)" << endl;
+    cerr << "  --persistance F     amplitude factor between octaves (default 0.5)" << endl;
+    cerr << "  --scale F           noise scale (default 3)" << endl;
+    cerr << "  --surface F         surface level (default 0.5)" << endl;
+    cerr << "  --cube-size F       size of a cube (default 0.1)" << endl;
+    cerr << "  --min-region N      minimum node and triangle count of a region (default 1000)" << endl;
+    cerr << "  --normals MODE      face, area or gradient (default face)" << endl;
+    cerr << "  --threads N         worker threads, 0 for one per hardware thread (default 0)" << endl;
+    cerr << "  --no-optimize       keep the marching order of the triangles and vertices" << endl;
+    cerr << "  --trace FILE        write the trace zones as Chrome trace JSON (built with MC_TRACE)" << endl;
+}
+
+// one line of the memory report, in kilobytes
+static void printMemory(const char *step, const MemoryTracker::Usage& usage)
+{
+    cout << step << setw(12) << usage.allocatedBytes / 1024. << setw(10) << usage.allocationCount;
+    cout << setw(12) << usage.peakBytes / 1024. << setw(12) << usage.retainedBytes / 1024. << endl;
+}
+
+// false for a value out of the int range rather than wrapping it
+static bool parseInt(const char *text, int& value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if(end == text || *end != '\0' || errno == ERANGE)
+        return false;
+    if(parsed < INT_MIN || parsed > INT_MAX)
+        return false;
+    value = (int)parsed;
+    return true;
+}
+
+static bool parseFloat(const char *text, float& value)
+{
+    char *end;
+    value = strtof(text, &end);
+    return end != text && *end == '\0';
+}
+
+// N or WxHxD
+static bool parseSize(const char *text, int& width, int& height, int& depth)
+{
+    string size = text;
+    size_t first = size.find('x');
+
+    if(first == string::npos){
+        if(!parseInt(text, width))
+            return false;
+        height = depth = width;
+        return width > 1;
+    }
+
+    size_t second = size.find('x', first + 1);
+    if(second == string::npos)
+        return false;
+
+    if(!parseInt(size.substr(0, first).c_str(), width) ||
+       !parseInt(size.substr(first + 1, second - first - 1).c_str(), height) ||
+       !parseInt(size.substr(second + 1).c_str(), depth))
+        return false;
+
+    return width > 1 && height > 1 && depth > 1;
+}
+
+static bool endsWith(const string& text, const string& suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int width = 50, height = 50, depth = 50;
+    int seed = 1337;
+    int octaves = 3;
+    float lacunarity = 2.f;
+    float persistance = 0.5f;
+    float scale = 3.f;
+    float surfaceLevel = 0.5f;
+    float cubeSize = 0.1f;
+    int minRegionSize = 1000;
+    Mesh::NormalMode normalMode = Mesh::FaceAverage;
+    int threadCount = 0;
+    bool optimize = true;
+    string output;
+    string tracePath;
+
+    for(int a = 1; a < argc; a++){
+        string option = argv[a];
+        const char *value = a + 1 < argc ? argv[a + 1] : nullptr;
+        bool valid = true;
+
+        if(option == "--no-optimize"){
+            optimize = false;
+            continue;
+        } else if(option == "--help" || option == "-h"){
+            printUsage();
+            return EXIT_SUCCESS;
+        } else if(option.compare(0, 2, "--") != 0){
+            output = option;
+            continue;
+        }
+
+        if(value == nullptr){
+            cerr << "missing value for " << option << endl;
+            return EXIT_FAILURE;
+        }
+        a++;
+
+        if(option == "--size"){
+            valid = parseSize(value, width, height, depth);
+        } else if(option == "--seed"){
+            valid = parseInt(value, seed);
+        } else if(option == "--octaves"){
+            valid = parseInt(value, octaves) && octaves > 0;
+        } else if(option == "--lacunarity"){
+            valid = parseFloat(value, lacunarity);
+        } else if(option == "--persistance"){
+            valid = parseFloat(value, persistance);
+        } else if(option == "--scale"){
+            valid = parseFloat(value, scale);
+        } else if(option == "--surface"){
+            valid = parseFloat(value, surfaceLevel);
+        } else if(option == "--cube-size"){
+            valid = parseFloat(value, cubeSize) && cubeSize > 0.f;
+        } else if(option == "--min-region"){
+            valid = parseInt(value, minRegionSize) && minRegionSize >= 0;
+        } else if(option == "--normals"){
+            if(strcmp(value, "face") == 0)
+                normalMode = Mesh::FaceAverage;
+            else if(strcmp(value, "area") == 0)
+                normalMode = Mesh::AreaWeighted;
+            else if(strcmp(value, "gradient") == 0)
+                normalMode = Mesh::FieldGradient;
+            else
+                valid = false;
+        } else if(option == "--threads"){
+            valid = parseInt(value, threadCount) && threadCount >= 0;
+        } else if(option == "--trace"){
+            tracePath = value;
+        } else {
+            cerr << "unknown option " << option << endl;
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        if(!valid){
+            cerr << "invalid value for " << option << " : " << value << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    bool ply = endsWith(output, ".ply");
+    if(!ply && !endsWith(output, ".obj")){
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    if(!tracePath.empty() && !Trace::enabled())
+        cerr << "built without MC_TRACE, no trace zone is recorded" << endl;
+
+    TRACE_THREAD_NAME("main");
+
+    MapGenerator generator(threadCount);
+    generator.gridWidth = width;
+    generator.gridHeight = height;
+    generator.gridDepth = depth;
+    generator.octaves = octaves;
+    generator.lacunarity = lacunarity;
+    generator.persistance = persistance;
+    generator.noiseScale = scale;
+    generator.surfaceLevel = surfaceLevel;
+    generator.cubeSize = cubeSize;
+    generator.minRegionSize = minRegionSize;
+    generator.normalMode = normalMode;
+    generator.optimizeMesh = optimize;
+
+    generator.generate(seed);
+
+    const Mesh& mesh = generator.mesh;
+    const MapGenerator::Timings& timings = generator.timings;
+
+    auto startTime = chrono::high_resolution_clock::now();
+    bool written = ply ? mesh.writePly(output) : mesh.writeObj(output);
+    double writeTime = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+
+    if(!written){
+        cerr << "could not write " << output << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "grid " << width << "x" << height << "x" << depth << ", seed " << seed;
+    cout << ", " << generator.getThreadCount() << " threads" << endl;
+    cout << mesh.vertices.size() << " vertices, " << mesh.triangles.size() << " triangles" << endl;
+    cout << "vertex cache ACMR " << generator.cacheBefore.acmr << " -> " << generator.cacheAfter.acmr << endl;
+
+    cout << fixed << setprecision(2);
+    cout << "fillGrid     " << setw(10) << timings.fillGrid << " ms" << endl;
+    cout << "generateGrid " << setw(10) << timings.generateGrid << " ms" << endl;
+    cout << "generateMesh " << setw(10) << timings.generateMesh << " ms" << endl;
+    cout << "optimizeMesh " << setw(10) << timings.optimizeMesh << " ms" << endl;
+    cout << "total        " << setw(10) << timings.total << " ms" << endl;
+    cout << "write        " << setw(10) << writeTime << " ms" << endl;
+
+    const MapGenerator::Memory& memory = generator.memory;
+
+    cout << "cell grid    " << setw(10) << memory.cellGridBytes / 1024. << " KB" << endl;
+    cout << "nodes        " << setw(10) << memory.nodeBytes / 1024. << " KB" << endl;
+    cout << "mesh         " << setw(10) << memory.meshBytes / 1024. << " KB" << endl;
+
+    if(MemoryTracker::enabled()){
+        cout << "heap (KB)    " << setw(12) << "allocated" << setw(10) << "count";
+        cout << setw(12) << "peak" << setw(12) << "retained" << endl;
+        printMemory("fillGrid     ", memory.fillGrid);
+        printMemory("generateGrid ", memory.generateGrid);
+        printMemory("generateMesh ", memory.generateMesh);
+        printMemory("optimizeMesh ", memory.optimizeMesh);
+    }
+
+    size_t resident = MemoryTracker::peakResidentBytes();
+    if(resident > 0)
+        cout << "peak resident" << setw(10) << resident / 1024. << " KB" << endl;
+
+    if(!tracePath.empty() && !Trace::writeChromeTrace(tracePath)){
+        cerr << "could not write " << tracePath << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}